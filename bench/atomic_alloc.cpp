@@ -0,0 +1,173 @@
+// Benchmarks the lock-free allocator against the mutex-guarded resource map.
+//
+// Every task thread repeatedly acquires all resources it requires, holds them for `hold` spin
+// iterations and releases them, once through the locked check-and-subtract that the simulator
+// uses for wide configurations and once through packedTryAcquire()/packedRelease() on a packed
+// word. Tasks that find their resources taken yield and retry instead of sleeping, so the
+// allocators run under as much contention as the rings allow. The rings mirror t1.in (dining
+// philosophers), t2.in (every pair of four 2-unit resources) and a ring over NRES_TYPES types.
+//
+// Usage: ./build/bench/atomic_alloc [iterations] [hold]
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "atomic_alloc.h"
+
+using std::vector;
+
+// A ring scenario: `nResources` resource types with `units` units each, and tasks requiring one
+// unit of each of two resource types.
+typedef struct {
+    const char *name;
+    int nResources;
+    int units;
+    vector<std::pair<int, int>> tasks;
+} SCENARIO;
+
+static long ITERATIONS = 200000;
+static long HOLD = 0;
+static pthread_barrier_t startBarrier;
+
+// The mutex-guarded resource map.
+static pthread_mutex_t mapMutex = PTHREAD_MUTEX_INITIALIZER;
+static int mapAvail[NRES_TYPES];
+
+// The packed word, with 1 + 2 bits per resource type (value bits for up to 3 units, guard bit).
+#define FIELD_BITS 3
+static ALLOC_WORD word;
+
+// The work of one task thread.
+typedef struct {
+    const SCENARIO *scenario;
+    int task;
+    bool atomic;
+    long retries;
+} WORKER;
+
+/**
+ * Spins for `HOLD` iterations while holding the resources.
+ */
+static void hold() {
+    for (volatile long i = 0; i < HOLD; i++) {
+    }
+}
+
+/**
+ * Entry point of a task thread: acquires and releases the task's resources ITERATIONS times.
+ * @param arg the thread's WORKER
+ */
+static void *worker(void *arg) {
+    auto *work = (WORKER *) arg;
+    int a = work->scenario->tasks[work->task].first;
+    int b = work->scenario->tasks[work->task].second;
+    uint64_t need = (1ULL << (a * FIELD_BITS)) + (1ULL << (b * FIELD_BITS));
+    pthread_barrier_wait(&startBarrier);
+
+    for (long i = 0; i < ITERATIONS; i++) {
+        if (work->atomic) {
+            while (!packedTryAcquire(word, need)) {
+                work->retries++;
+                sched_yield();
+            }
+            hold();
+            packedRelease(word, need);
+        } else {
+            for (;;) {
+                pthread_mutex_lock(&mapMutex);
+                if (mapAvail[a] >= 1 && mapAvail[b] >= 1) {
+                    mapAvail[a]--;
+                    mapAvail[b]--;
+                    pthread_mutex_unlock(&mapMutex);
+                    break;
+                }
+                pthread_mutex_unlock(&mapMutex);
+                work->retries++;
+                sched_yield();
+            }
+            hold();
+            pthread_mutex_lock(&mapMutex);
+            mapAvail[a]++;
+            mapAvail[b]++;
+            pthread_mutex_unlock(&mapMutex);
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * Runs all tasks of a scenario through one allocator and prints the grant rate.
+ * @param scenario the ring to run
+ * @param atomic whether to use the packed word instead of the mutex
+ */
+static void runScenario(const SCENARIO &scenario, bool atomic) {
+    uint64_t avail = 0;
+    word.guards = 0;
+    for (int r = 0; r < scenario.nResources; r++) {
+        mapAvail[r] = scenario.units;
+        avail |= (uint64_t) scenario.units << (r * FIELD_BITS);
+        word.guards |= 1ULL << (r * FIELD_BITS + FIELD_BITS - 1);
+    }
+    word.avail.store(avail);
+
+    size_t nTasks = scenario.tasks.size();
+    vector<WORKER> work(nTasks);
+    vector<pthread_t> threads(nTasks);
+    pthread_barrier_init(&startBarrier, nullptr, nTasks + 1);
+    for (size_t t = 0; t < nTasks; t++) {
+        work[t] = WORKER{&scenario, (int) t, atomic, 0};
+        if (pthread_create(&threads[t], nullptr, worker, &work[t])) {
+            fprintf(stderr, "pthread_create failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    pthread_barrier_wait(&startBarrier);
+    long retries = 0;
+    for (size_t t = 0; t < nTasks; t++) {
+        pthread_join(threads[t], nullptr);
+        retries += work[t].retries;
+    }
+    double msec = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    pthread_barrier_destroy(&startBarrier);
+
+    printf("%-8s %-6s: time= %8.1f msec, grants/sec= %10.0f, retries/grant= %.3f\n", scenario.name,
+           atomic ? "atomic" : "mutex", msec, nTasks * ITERATIONS / (msec / 1000), retries / (double) (nTasks * ITERATIONS));
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) {
+        ITERATIONS = atol(argv[1]);
+    }
+    if (argc > 2) {
+        HOLD = atol(argv[2]);
+    }
+    printf("atomic_alloc: %ld iterations, hold= %ld, %ld cpus\n", ITERATIONS, HOLD, sysconf(_SC_NPROCESSORS_ONLN));
+
+    vector<SCENARIO> scenarios(3);
+    scenarios[0] = SCENARIO{"t1", 5, 1, {}};
+    for (int r = 0; r < 5; r++) {
+        scenarios[0].tasks.emplace_back(r, (r + 1) % 5);
+    }
+    scenarios[1] = SCENARIO{"t2", 4, 2, {}};
+    for (int a = 0; a < 4; a++) {
+        for (int b = a + 1; b < 4; b++) {
+            scenarios[1].tasks.emplace_back(a, b);
+        }
+    }
+    scenarios[2] = SCENARIO{"ring10", NRES_TYPES, 1, {}};
+    for (int r = 0; r < NRES_TYPES; r++) {
+        scenarios[2].tasks.emplace_back(r, (r + 1) % NRES_TYPES);
+    }
+
+    for (const SCENARIO &scenario : scenarios) {
+        runScenario(scenario, false);
+        runScenario(scenario, true);
+    }
+    return EXIT_SUCCESS;
+}
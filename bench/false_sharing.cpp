@@ -0,0 +1,161 @@
+// Benchmarks the per-task counter layout used by the task threads.
+//
+// Every task thread repeatedly updates its own status and counters the same way runTask() does,
+// once with the counters embedded in a packed array of structs that mirrors the original TASK
+// layout, and once with the cache-line-padded TASK_STATE array. Hardware cache misses are read
+// through perf_event_open(2), so the false sharing between neighbouring tasks shows up directly.
+//
+// Usage: ./build/bench/false_sharing [nTasks] [iterations]
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "task.h"
+
+using std::vector;
+
+// The original task layout, with hot counters next to cold metadata in one packed struct.
+typedef struct {
+    char name[100];
+    int busyTime;
+    int idleTime;
+    long totalBusyTime;
+    long totalIdleTime;
+    long totalWaitTime;
+    vector<string> reqResources;
+    bool assigned;
+    int timesExecuted;
+    STATUS status;
+} LEGACY_TASK;
+
+static long ITERATIONS = 1000000;
+static pthread_barrier_t startBarrier;
+
+/**
+ * Opens a hardware counter that follows the calling thread and any thread it creates.
+ * @param type the perf event type
+ * @param config the PERF_COUNT_HW_* or PERF_TYPE_HW_CACHE event to count
+ * @return the counter's file descriptor, or -1 if counters are unavailable
+ */
+static int openCounter(unsigned int type, unsigned long long config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+/**
+ * Reads a counter opened with openCounter().
+ * @param fd the counter's file descriptor
+ * @return the counter value, or -1 if the counter is unavailable
+ */
+static long long readCounter(int fd) {
+    long long value;
+    if (fd < 0 || read(fd, &value, sizeof(value)) != sizeof(value)) {
+        return -1;
+    }
+    return value;
+}
+
+/**
+ * Applies one simulated iteration worth of status and counter updates to a task.
+ */
+template <typename T>
+static void *hammer(void *arg) {
+    T *task = (T *) arg;
+    pthread_barrier_wait(&startBarrier);
+    for (long i = 0; i < ITERATIONS; i++) {
+        task->status = WAIT;
+        task->totalWaitTime += 1;
+        task->status = RUN;
+        task->totalBusyTime += 1;
+        task->status = IDLE;
+        task->totalIdleTime += 1;
+        task->timesExecuted += 1;
+        asm volatile("" ::: "memory"); // keep every store in the loop
+    }
+    return nullptr;
+}
+
+/**
+ * Runs one thread per task over the given task array and prints the measured counters.
+ * @param label name of the layout being measured
+ * @param tasks the task array
+ */
+template <typename T>
+static void measure(const char *label, vector<T> &tasks) {
+    vector<pthread_t> threads(tasks.size());
+    int misses = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    int l1dMisses = openCounter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+                                                    (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                                    (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    pthread_barrier_init(&startBarrier, NULL, tasks.size() + 1);
+
+    for (int fd : {misses, l1dMisses}) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+    for (unsigned long i = 0; i < tasks.size(); i++) {
+        if (pthread_create(&threads[i], NULL, hammer<T>, &tasks[i])) {
+            fprintf(stderr, "pthread_create failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    auto start = std::chrono::steady_clock::now();
+    pthread_barrier_wait(&startBarrier);
+    for (auto &thread : threads) {
+        pthread_join(thread, NULL);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    for (int fd : {misses, l1dMisses}) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+
+    printf("%-8s (%3zu bytes/task): time= %8.1f msec, cache-misses= %lld, L1D-read-misses= %lld\n",
+           label, sizeof(T), std::chrono::duration<double, std::milli>(elapsed).count(),
+           readCounter(misses), readCounter(l1dMisses));
+    pthread_barrier_destroy(&startBarrier);
+    if (misses >= 0) close(misses);
+    if (l1dMisses >= 0) close(l1dMisses);
+}
+
+int main(int argc, char *argv[]) {
+    unsigned long nTasks = argc > 1 ? strtoul(argv[1], nullptr, 10) : 64;
+    if (argc > 2) {
+        ITERATIONS = atol(argv[2]);
+    }
+
+    printf("false_sharing: %lu tasks, %ld iterations, %ld cpus\n", nTasks, ITERATIONS,
+           sysconf(_SC_NPROCESSORS_ONLN));
+
+    vector<LEGACY_TASK> legacy(nTasks);
+    measure("packed", legacy);
+
+    vector<TASK_STATE> padded(nTasks);
+    measure("padded", padded);
+
+    int probe = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    if (probe < 0) {
+        printf("note: hardware counters unavailable (check /proc/sys/kernel/perf_event_paranoid)\n");
+    } else {
+        close(probe);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,50 @@
+#!/bin/sh
+# Measures the weak scaling of the sharded mode on a random-contention scenario.
+#
+# For each shard count N, generates a scenario with N * TASKS_PER_SHARD tasks over
+# N * RES_PER_SHARD resource types, where each task needs two resource types drawn
+# from its own group (the types the simulator assigns to one shard) with probability
+# LOCALITY and from all types otherwise. It then runs N shards and reports the total
+# throughput and the scaling efficiency throughput(N) / (N * throughput(1)).
+#
+# Usage: bench/shard_scaling.sh [transport] [NITER]   (run from the repository root)
+
+TRANSPORT=${1:-shm}
+NITER=${2:-50}
+TASKS_PER_SHARD=${TASKS_PER_SHARD:-32}
+RES_PER_SHARD=${RES_PER_SHARD:-4}
+LOCALITY=${LOCALITY:-0.9}
+SCENARIO=$(mktemp)
+
+printf "%6s %8s %10s %14s %10s\n" shards tasks time_ms iter_per_sec efficiency
+for N in 1 2 4 8; do
+    awk -v n=$N -v tps=$TASKS_PER_SHARD -v rps=$RES_PER_SHARD -v loc=$LOCALITY -v seed=$N 'BEGIN {
+        srand(seed);
+        nres = n * rps;
+        for (r = 0; r < nres; r++) {
+            printf("%s R%d:2", (r % 8 == 0) ? (r ? "\nresources" : "resources") : "", r);
+        }
+        printf("\n");
+        for (t = 0; t < n * tps; t++) {
+            group = t % n;
+            a = -1;
+            for (k = 0; k < 2; k++) {
+                do {
+                    if (rand() < loc) r = group + n * int(rand() * rps); else r = int(rand() * nres);
+                } while (r == a);
+                req[k] = r;
+                a = r;
+            }
+            printf("task t%d 5 5 R%d:1 R%d:1\n", t, req[0], req[1]);
+        }
+    }' > "$SCENARIO"
+
+    TIME=$(./a4w23tasks "$SCENARIO" 0 "$NITER" --shards $N --transport "$TRANSPORT" |
+           sed -n 's/^Running time= \([0-9]*\) msec/\1/p')
+    TPUT=$(awk -v tasks=$((N * TASKS_PER_SHARD)) -v niter=$NITER -v ms=$TIME \
+               'BEGIN { printf("%.1f", tasks * niter / (ms / 1000.0)) }')
+    [ $N -eq 1 ] && BASE=$TPUT
+    awk -v n=$N -v tasks=$((N * TASKS_PER_SHARD)) -v ms=$TIME -v tput=$TPUT -v base=$BASE \
+        'BEGIN { printf("%6d %8d %10d %14.1f %10.2f\n", n, tasks, ms, tput, tput / (n * base)) }'
+done
+rm -f "$SCENARIO"
@@ -0,0 +1,154 @@
+// This code implements the lock-free allocator declared in atomic_alloc.h.
+
+#include "atomic_alloc.h"
+#include "task_manager.h"
+#include <algorithm>
+#include <numeric>
+#include <stdio.h>
+
+// The location of a resource type's field in the allocation words.
+typedef struct {
+    unsigned int word; // index of the word holding the field
+    unsigned int shift; // position of the field's lowest bit
+    unsigned int width; // number of value bits, not counting the guard bit
+} ALLOC_FIELD;
+
+// A task's requirement vector packed into the word holding all of its resource types.
+typedef struct {
+    unsigned int word; // index of the word
+    uint64_t need; // the task's units, each shifted to its resource type's field
+} PACKED_REQ;
+
+static bool enabled = false; // whether grants go through the packed words
+static ALLOC_WORD words[ATOMIC_ALLOC_WORDS]; // the packed availability counters
+static unsigned int nWords = 0; // the number of words in use
+static std::vector<ALLOC_FIELD> fields; // the field of each resource type
+static std::vector<PACKED_REQ> packedReqs; // the packed requirements of each task
+
+/**
+ * Finds the representative of a resource type's group
+ * @param parent the union-find forest over resource types
+ * @param r index of the resource type
+ */
+static unsigned long findGroup(std::vector<unsigned long> &parent, unsigned long r) {
+    while (parent[r] != r) {
+        r = parent[r] = parent[parent[r]];
+    }
+    return r;
+}
+
+bool atomicAllocInit() {
+    unsigned long nResources = resourceNames.size();
+    fields.assign(nResources, ALLOC_FIELD{0, 0, 0});
+    for (unsigned long r = 0; r < nResources; r++) {
+        while (fields[r].width < 31 && (1L << fields[r].width) <= resourceMaxAvail[r]) {
+            fields[r].width++;
+        }
+        fields[r].width = std::max(fields[r].width, 1u);
+    }
+
+    // group the resource types a task requires together, since they must share a word
+    std::vector<unsigned long> parent(nResources);
+    std::iota(parent.begin(), parent.end(), 0);
+    for (unsigned long id = 0; id < taskInfo.size(); id++) {
+        const RESOURCE_REQ *reqs = taskReqs(id);
+        for (unsigned int i = 0; i < taskInfo[id].reqCount; i++) {
+            if (reqs[i].units > resourceMaxAvail[reqs[i].resource]) {
+                return false; // the units would overflow into the guard bit
+            }
+            parent[findGroup(parent, reqs[i].resource)] = findGroup(parent, reqs[0].resource);
+        }
+    }
+    std::vector<unsigned int> groupBits(nResources, 0);
+    for (unsigned long r = 0; r < nResources; r++) {
+        groupBits[findGroup(parent, r)] += fields[r].width + 1;
+    }
+
+    // place the groups into words first-fit, widest group first
+    std::vector<unsigned long> groups;
+    for (unsigned long r = 0; r < nResources; r++) {
+        if (findGroup(parent, r) == r) {
+            groups.push_back(r);
+        }
+    }
+    std::sort(groups.begin(), groups.end(), [&](unsigned long a, unsigned long b) {
+        return groupBits[a] > groupBits[b];
+    });
+    unsigned int used[ATOMIC_ALLOC_WORDS] = {0};
+    std::vector<unsigned int> groupWord(nResources);
+    nWords = 0;
+    for (unsigned long group : groups) {
+        unsigned int w = 0;
+        while (w < ATOMIC_ALLOC_WORDS && used[w] + groupBits[group] > 64) {
+            w++;
+        }
+        if (w == ATOMIC_ALLOC_WORDS) {
+            return false;
+        }
+        groupWord[group] = w;
+        used[w] += groupBits[group];
+        nWords = std::max(nWords, w + 1);
+    }
+
+    // lay out the fields of each word and store the initial availability
+    std::fill(used, used + ATOMIC_ALLOC_WORDS, 0);
+    uint64_t avail[ATOMIC_ALLOC_WORDS] = {0};
+    for (unsigned int w = 0; w < ATOMIC_ALLOC_WORDS; w++) {
+        words[w].guards = 0;
+    }
+    for (unsigned long r = 0; r < nResources; r++) {
+        ALLOC_FIELD &field = fields[r];
+        field.word = groupWord[findGroup(parent, r)];
+        field.shift = used[field.word];
+        used[field.word] += field.width + 1;
+        words[field.word].guards |= 1ULL << (field.shift + field.width);
+        avail[field.word] |= (uint64_t) resourceAvail[r] << field.shift;
+    }
+    for (unsigned int w = 0; w < ATOMIC_ALLOC_WORDS; w++) {
+        words[w].avail.store(avail[w], std::memory_order_relaxed);
+    }
+
+    packedReqs.assign(taskInfo.size(), PACKED_REQ{0, 0});
+    for (unsigned long id = 0; id < taskInfo.size(); id++) {
+        const RESOURCE_REQ *reqs = taskReqs(id);
+        for (unsigned int i = 0; i < taskInfo[id].reqCount; i++) {
+            packedReqs[id].word = fields[reqs[i].resource].word;
+            packedReqs[id].need += (uint64_t) reqs[i].units << fields[reqs[i].resource].shift;
+        }
+    }
+
+    enabled = true;
+    return true;
+}
+
+bool atomicAllocEnabled() {
+    return enabled;
+}
+
+bool atomicAllocTryAcquire(unsigned long id) {
+    return packedTryAcquire(words[packedReqs[id].word], packedReqs[id].need);
+}
+
+void atomicAllocRelease(unsigned long id) {
+    packedRelease(words[packedReqs[id].word], packedReqs[id].need);
+}
+
+void atomicAllocClose() {
+    if (!enabled) {
+        return;
+    }
+    for (unsigned long r = 0; r < fields.size(); r++) {
+        uint64_t avail = words[fields[r].word].avail.load(std::memory_order_acquire);
+        resourceAvail[r] = (int) ((avail >> fields[r].shift) & ((1ULL << fields[r].width) - 1));
+    }
+}
+
+std::string getFormattedAtomicAllocInfo() {
+    if (!enabled) {
+        return "";
+    }
+    char buffer[256];
+    sprintf(buffer, "Allocator: atomic (%lu resource types in %u packed word%s)\n", (unsigned long) fields.size(),
+            nWords, nWords == 1 ? "" : "s");
+    return buffer;
+}
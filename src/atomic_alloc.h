@@ -0,0 +1,108 @@
+// The following defines the lock-free allocator that grants a task's resources with a single
+// compare-and-swap.
+//
+// The availability counters of all resource types are packed into at most ATOMIC_ALLOC_WORDS
+// 64-bit words. Each resource type gets a field just wide enough to hold its maximum availability,
+// plus a guard bit above it that is always clear in the stored word. A task's requirement vector
+// is packed the same way, so with `guards` holding every guard bit of a word,
+//
+//     remaining = (avail | guards) - need
+//
+// subtracts every requirement at once: a field that has too few units borrows from its own guard
+// bit, and the task is granted all of its resources iff every guard bit survived, in which case
+// `remaining & ~guards` is the new availability, stored with one CAS. A release is a single
+// fetch_add and can never carry into a neighbouring field, since availability never exceeds the
+// maximum. Resource types are assigned to words so every task's requirements share one word.
+//
+// Configurations that do not fit (too many units, or resource types linked by tasks whose fields
+// need more than 64 bits) fall back to the locked path in task_manager.cpp, as do the modes that
+// observe grants under the resource mutex (profiler, grant log, shared memory state, shards, task
+// dependencies).
+
+#ifndef ATOMIC_ALLOC_H
+#define ATOMIC_ALLOC_H
+
+#include "task.h"
+#include <atomic>
+#include <stdint.h>
+#include <string>
+
+// Define the allocators that can be selected on the command line.
+#define AUTO_ALLOCATOR "auto"
+#define ATOMIC_ALLOCATOR "atomic"
+#define MUTEX_ALLOCATOR "mutex"
+
+// Define the maximum number of words the availability counters may be packed into.
+#define ATOMIC_ALLOC_WORDS 2
+
+// A word of packed availability counters, on a cache line of its own.
+struct alignas(CACHE_LINE_SIZE) ALLOC_WORD {
+    std::atomic<uint64_t> avail; // the packed availability of the word's resource types
+    uint64_t guards; // the guard bit above each field of the word
+};
+
+/**
+ * Grants a packed requirement vector if every field of the word has enough units.
+ * @param word the word holding the requested resource types
+ * @param need the requirement vector, packed into the word's fields
+ * @return true if all requested units were taken, false if any were unavailable
+ */
+inline bool packedTryAcquire(ALLOC_WORD &word, uint64_t need) {
+    uint64_t current = word.avail.load(std::memory_order_relaxed);
+    for (;;) {
+        uint64_t remaining = (current | word.guards) - need;
+        if ((remaining & word.guards) != word.guards) {
+            return false;
+        }
+        if (word.avail.compare_exchange_weak(current, remaining & ~word.guards, std::memory_order_acquire,
+                                             std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+}
+
+/**
+ * Returns a packed requirement vector to its word.
+ * @param word the word holding the requested resource types
+ * @param need the requirement vector, packed into the word's fields
+ */
+inline void packedRelease(ALLOC_WORD &word, uint64_t need) {
+    word.avail.fetch_add(need, std::memory_order_release);
+}
+
+/**
+ * Packs the resource tables and the requirements of all tasks into allocation words.
+ * @return false if the configuration does not fit, in which case the allocator stays disabled
+ */
+bool atomicAllocInit();
+
+/**
+ * Returns whether resources are granted by the lock-free allocator.
+ */
+bool atomicAllocEnabled();
+
+/**
+ * Grants all resources a task requires if they are available, without waiting.
+ * @param id index of the task
+ * @return true if the resources were granted
+ */
+bool atomicAllocTryAcquire(unsigned long id);
+
+/**
+ * Returns all resources a task holds.
+ * @param id index of the task
+ */
+void atomicAllocRelease(unsigned long id);
+
+/**
+ * Copies the packed availability back into the resource tables for the termination report.
+ */
+void atomicAllocClose();
+
+/**
+ * Formats a summary of the packing for the termination report.
+ * @return the summary, or an empty string if the allocator is disabled
+ */
+std::string getFormattedAtomicAllocInfo();
+
+#endif //ATOMIC_ALLOC_H
@@ -0,0 +1,204 @@
+// This code implements the busy modes declared in busy.h.
+
+#include "busy.h"
+#include "task_manager.h"
+#include "util.h"
+#include <algorithm>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+// Define the work of one kernel chunk: loop iterations of the cpu kernel, bytes read by the memory kernel.
+#define CPU_CHUNK_ITERATIONS 1024
+#define MEMORY_CHUNK_BYTES (16L << 10)
+
+// The busy time statistics of a task, written only by the task's own thread.
+struct alignas(CACHE_LINE_SIZE) BUSY_STATS {
+    long long requestedNs; // the busy time the task asked for
+    long long achievedNs; // the wall time the busy periods took
+    long long cpuNs; // the CPU time the task's thread spent in them
+    unsigned long memoryOffset; // where the task's next memory chunk starts
+};
+
+static bool enabled = false; // whether busy time is spent in a kernel
+static bool memoryKernel = false; // whether the kernel is the memory kernel
+static double chunksPerMs[CPU_SETSIZE]; // the calibrated rate of each core (0 = not calibrated)
+static double meanChunksPerMs = 0; // the mean rate of the calibrated cores
+static int nCores = 0; // the number of calibrated cores
+static std::vector<BUSY_STATS> busyStats; // the statistics of each task
+static std::vector<uint64_t> memoryBuffer; // the buffer the memory kernel streams over
+static struct rusage startUsage; // the process's CPU usage when calibration finished
+static volatile uint64_t sink; // keeps the kernels' results alive
+
+/**
+ * Returns the CPU time the calling thread has used, in nanoseconds.
+ */
+static long long threadCpuNs() {
+    struct timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/**
+ * Runs chunks of the selected kernel
+ * @param chunks the number of chunks to run
+ * @param offset the position in the memory buffer to continue reading at, advanced past the chunks
+ */
+static void runKernel(long chunks, unsigned long &offset) {
+    if (memoryKernel) {
+        uint64_t sum = 0;
+        unsigned long words = memoryBuffer.size();
+        for (long c = 0; c < chunks; c++) {
+            // one word per cache line, so every line of the chunk is fetched from memory
+            for (unsigned long w = 0; w < MEMORY_CHUNK_BYTES / sizeof(uint64_t); w += CACHE_LINE_SIZE / sizeof(uint64_t)) {
+                sum += memoryBuffer[(offset + w) % words];
+            }
+            offset = (offset + MEMORY_CHUNK_BYTES / sizeof(uint64_t)) % words;
+        }
+        sink = sum;
+    } else {
+        uint64_t x = 0x9e3779b97f4a7c15ULL + offset;
+        double f = 1.0;
+        for (long i = 0; i < chunks * CPU_CHUNK_ITERATIONS; i++) {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            f = f * 0.999999 + (double) (x & 0xffff) * 1e-9;
+        }
+        sink = x + (uint64_t) f;
+    }
+}
+
+/**
+ * Entry point for a calibration thread.
+ * Pins itself to a core and measures how many kernel chunks the core completes per millisecond.
+ * @param arg the index of the core
+ * @return Null pointer
+ */
+static void *calibrationThread(void *arg) {
+    auto cpu = (long) arg;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set)) {
+        return nullptr; // the core is not usable
+    }
+
+    unsigned long offset = cpu * MEMORY_CHUNK_BYTES / sizeof(uint64_t);
+    runKernel(1, offset); // warm up
+    double best = 0;
+    for (int round = 0; round < BUSY_CALIBRATION_ROUNDS; round++) {
+        long chunks = 0;
+        long long start = monotonic_ns(), elapsed;
+        do {
+            runKernel(16, offset);
+            chunks += 16;
+        } while ((elapsed = monotonic_ns() - start) < BUSY_CALIBRATION_MS * 1000000LL / BUSY_CALIBRATION_ROUNDS);
+        best = std::max(best, chunks / (elapsed / 1000000.0));
+    }
+    chunksPerMs[cpu] = best;
+    return nullptr;
+}
+
+void busyInit(const std::string &mode, unsigned long nTasks) {
+    memoryKernel = mode == MEMORY_BUSY;
+    if (memoryKernel) {
+        memoryBuffer.resize(BUSY_MEMORY_BYTES / sizeof(uint64_t));
+        for (unsigned long w = 0; w < memoryBuffer.size(); w++) {
+            memoryBuffer[w] = w; // fault every page in before calibrating
+        }
+    }
+
+    // calibrate the cores one at a time, so each is measured without competition
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    sched_getaffinity(0, sizeof(allowed), &allowed);
+    printf("Calibrating %s busy kernel on %d cores...\n", mode.c_str(), CPU_COUNT(&allowed));
+    double total = 0;
+    for (long cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &allowed)) {
+            pthread_t thread = do_pthread_create_with_error_check(calibrationThread, (void *) cpu);
+            do_pthread_join_with_error_check(&thread);
+            if (chunksPerMs[cpu] > 0) {
+                total += chunksPerMs[cpu];
+                nCores++;
+            }
+        }
+    }
+    if (!nCores) {
+        printf("ERROR: calibrating the busy kernel failed\n");
+        exit(EXIT_FAILURE);
+    }
+    meanChunksPerMs = total / nCores;
+
+    busyStats.assign(nTasks, BUSY_STATS{0, 0, 0, 0});
+    for (unsigned long id = 0; memoryKernel && id < nTasks; id++) {
+        // spread the tasks over the buffer, so they do not read the same lines at the same time
+        busyStats[id].memoryOffset = id * 4099 * (MEMORY_CHUNK_BYTES / sizeof(uint64_t)) % memoryBuffer.size();
+    }
+    getrusage(RUSAGE_SELF, &startUsage);
+    enabled = true;
+}
+
+bool busyEnabled() {
+    return enabled;
+}
+
+void busyRun(unsigned long id, int msec) {
+    BUSY_STATS &stats = busyStats[id];
+    int cpu = sched_getcpu();
+    double rate = cpu >= 0 && cpu < CPU_SETSIZE && chunksPerMs[cpu] > 0 ? chunksPerMs[cpu] : meanChunksPerMs;
+
+    long long start = monotonic_ns(), cpuStart = threadCpuNs();
+    runKernel((long) (rate * msec + 0.5), stats.memoryOffset);
+    stats.achievedNs += monotonic_ns() - start;
+    stats.cpuNs += threadCpuNs() - cpuStart;
+    stats.requestedNs += msec * 1000000LL;
+}
+
+std::string getFormattedBusyInfo(double runningTime) {
+    if (!enabled) {
+        return "";
+    }
+    long long requested = 0, achieved = 0, cpu = 0;
+    double maxStretch = 0;
+    unsigned long maxTask = 0;
+    double minRate = meanChunksPerMs, maxRate = meanChunksPerMs;
+    for (unsigned long id = 0; id < busyStats.size(); id++) {
+        requested += busyStats[id].requestedNs;
+        achieved += busyStats[id].achievedNs;
+        cpu += busyStats[id].cpuNs;
+        if (busyStats[id].requestedNs && busyStats[id].achievedNs / (double) busyStats[id].requestedNs > maxStretch) {
+            maxStretch = busyStats[id].achievedNs / (double) busyStats[id].requestedNs;
+            maxTask = id;
+        }
+    }
+    for (int c = 0; c < CPU_SETSIZE; c++) {
+        if (chunksPerMs[c] > 0) {
+            minRate = std::min(minRate, chunksPerMs[c]);
+            maxRate = std::max(maxRate, chunksPerMs[c]);
+        }
+    }
+
+    // the process's CPU time since calibration, over the capacity of the calibrated cores
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    double processCpu = (usage.ru_utime.tv_sec - startUsage.ru_utime.tv_sec + usage.ru_stime.tv_sec -
+                         startUsage.ru_stime.tv_sec) * 1000.0 +
+                        (usage.ru_utime.tv_usec - startUsage.ru_utime.tv_usec + usage.ru_stime.tv_usec -
+                         startUsage.ru_stime.tv_usec) / 1000.0;
+
+    char buffer[1024];
+    sprintf(buffer, "Busy mode: %s kernel, calibrated on %d cores (%.1f-%.1f chunks/msec)\n"
+                    "\t requested= %.0f msec, achieved= %.0f msec (%.2fx), kernel CPU time= %.0f msec\n"
+                    "\t most stretched task= %s (%.2fx)\n"
+                    "\t CPU utilization= %.1f%% of %d cores (process CPU time= %.0f msec)\n",
+            memoryKernel ? MEMORY_BUSY : CPU_BUSY, nCores, minRate, maxRate, requested / 1e6, achieved / 1e6,
+            requested ? achieved / (double) requested : 0.0, cpu / 1e6, busyStats.empty() ? "-" : taskName(maxTask),
+            maxStretch, runningTime > 0 ? 100.0 * processCpu / (runningTime * nCores) : 0.0, nCores, processCpu);
+    return buffer;
+}
@@ -0,0 +1,62 @@
+// The following defines the busy modes a task can spend its busy time in.
+//
+// By default a running task sleeps through its busy time, so it consumes no CPU. In the CPU busy
+// modes it instead executes a compute kernel for an amount of work calibrated to take the requested
+// time on an otherwise idle core, so tasks load real cores and the effects of oversubscription
+// (more running tasks than cores) show up as busy periods that take longer than requested:
+//
+//     cpu      an integer/floating point mix (xorshift and multiply-add) that stays in registers
+//     memory   streaming reads over a BUSY_MEMORY_BYTES buffer, much larger than the last-level
+//              cache, so tasks compete for memory bandwidth
+//
+// The kernel runs in chunks of fixed work. At startup a thread pinned to each core the process may
+// run on measures how many chunks that core completes per millisecond; a busy period then runs as
+// many chunks as the core the task is on completes in the requested time.
+
+#ifndef BUSY_H
+#define BUSY_H
+
+#include <string>
+
+// Define the busy modes that can be selected on the command line.
+#define SLEEP_BUSY "sleep"
+#define CPU_BUSY "cpu"
+#define MEMORY_BUSY "memory"
+
+// Define the time each core is calibrated for, in milliseconds, split into rounds of which the
+// fastest is kept, so interruptions during calibration do not understate the core's speed.
+#define BUSY_CALIBRATION_MS 20
+#define BUSY_CALIBRATION_ROUNDS 5
+
+// Define the size of the buffer the memory kernel streams over.
+#define BUSY_MEMORY_BYTES (64L << 20)
+
+/**
+ * Calibrates the kernel of a CPU busy mode on every core the process may run on.
+ * @param mode CPU_BUSY or MEMORY_BUSY
+ * @param nTasks the number of tasks, used to size the per-task statistics
+ */
+void busyInit(const std::string &mode, unsigned long nTasks);
+
+/**
+ * Returns whether busy time is spent in a compute kernel instead of sleeping.
+ */
+bool busyEnabled();
+
+/**
+ * Runs the calibrated kernel for a busy period and records the achieved wall and CPU time. Must be
+ * called by the task's own thread.
+ * @param id index of the task
+ * @param msec the requested busy time in milliseconds
+ */
+void busyRun(unsigned long id, int msec);
+
+/**
+ * Formats the achieved against the requested busy time and the CPU utilization for the
+ * termination report.
+ * @param runningTime the running time of the simulation in milliseconds
+ * @return the summary, or an empty string if busy time is slept
+ */
+std::string getFormattedBusyInfo(double runningTime);
+
+#endif //BUSY_H
@@ -0,0 +1,233 @@
+// This code implements the precedence engine declared in dag.h.
+
+#include "dag.h"
+#include "task_manager.h"
+#include "util.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Define the maximum number of task names printed for the critical path.
+#define MAX_PATH_NAMES 8
+
+// The precedence state of a task.
+struct alignas(CACHE_LINE_SIZE) DAG_NODE {
+    std::atomic<unsigned int> completed; // the number of iterations the task has completed
+    std::atomic<int> waiters; // the number of successors blocked on `cond`
+    bool finished; // whether the task stopped running, protected by `mutex`
+    pthread_mutex_t mutex; // guards the wait on `cond`
+    pthread_cond_t cond; // broadcast when an iteration completes or the task finishes
+    pthread_cond_t grantCond; // signalled, under the resource mutex, when the task is granted its resources
+    long long firstGrant; // the time the task's first iteration was granted its resources
+    long long lastEnd; // the time the task's last iteration completed
+    long long dependencyWait; // the time the task spent blocked on its predecessors, in nanoseconds
+};
+
+static bool enabled = false; // whether tasks have precedence constraints
+static std::unique_ptr<DAG_NODE[]> nodes; // the precedence state of each task
+static std::vector<long> priority; // the critical path length from each task to the end of the graph
+static std::vector<unsigned int> stage; // the stage of each task
+static unsigned int nStages = 0; // the number of stages
+static std::vector<unsigned long> criticalPath; // the tasks on the critical path, in order
+
+bool dagInit() {
+    unsigned long nTasks = taskInfo.size();
+    if (taskAfterArena.empty()) {
+        return false;
+    }
+
+    // build the successor lists, then order the tasks topologically (Kahn's algorithm)
+    std::vector<unsigned int> successorOffset(nTasks + 1, 0), successors(taskAfterArena.size());
+    std::vector<unsigned int> remaining(nTasks);
+    for (unsigned long id = 0; id < nTasks; id++) {
+        remaining[id] = taskInfo[id].afterCount;
+        for (unsigned int i = 0; i < taskInfo[id].afterCount; i++) {
+            successorOffset[taskAfter(id)[i] + 1]++;
+        }
+    }
+    for (unsigned long id = 0; id < nTasks; id++) {
+        successorOffset[id + 1] += successorOffset[id];
+    }
+    std::vector<unsigned int> fill(successorOffset.begin(), successorOffset.end() - 1);
+    for (unsigned long id = 0; id < nTasks; id++) {
+        for (unsigned int i = 0; i < taskInfo[id].afterCount; i++) {
+            successors[fill[taskAfter(id)[i]]++] = id;
+        }
+    }
+    std::vector<unsigned long> order;
+    for (unsigned long id = 0; id < nTasks; id++) {
+        if (!remaining[id]) {
+            order.push_back(id);
+        }
+    }
+    stage.assign(nTasks, 0);
+    for (unsigned long next = 0; next < order.size(); next++) {
+        unsigned long id = order[next];
+        for (unsigned int s = successorOffset[id]; s < successorOffset[id + 1]; s++) {
+            stage[successors[s]] = std::max(stage[successors[s]], stage[id] + 1);
+            if (!--remaining[successors[s]]) {
+                order.push_back(successors[s]);
+            }
+        }
+        nStages = std::max(nStages, stage[id] + 1);
+    }
+    if (order.size() != nTasks) {
+        printf("ERROR: THE AFTER CLAUSES OF THE TASKS FORM A CYCLE\n");
+        exit(EINVAL);
+    }
+
+    // the priority of a task is its own busy and idle time plus the longest priority of its successors
+    priority.assign(nTasks, 0);
+    std::vector<unsigned long> next(nTasks, nTasks);
+    for (unsigned long i = nTasks; i-- > 0;) {
+        unsigned long id = order[i];
+        long longest = 0;
+        for (unsigned int s = successorOffset[id]; s < successorOffset[id + 1]; s++) {
+            if (priority[successors[s]] >= longest) {
+                longest = priority[successors[s]];
+                next[id] = successors[s];
+            }
+        }
+        priority[id] = taskInfo[id].busyTime + taskInfo[id].idleTime + longest;
+    }
+    unsigned long head = std::max_element(priority.begin(), priority.end()) - priority.begin();
+    for (unsigned long id = head; id < nTasks; id = next[id]) {
+        criticalPath.push_back(id);
+    }
+
+    nodes.reset(new DAG_NODE[nTasks]);
+    for (unsigned long id = 0; id < nTasks; id++) {
+        nodes[id].completed.store(0);
+        nodes[id].waiters.store(0);
+        nodes[id].finished = false;
+        mutex_init(&nodes[id].mutex);
+        cond_init(&nodes[id].cond);
+        cond_init(&nodes[id].grantCond);
+        nodes[id].firstGrant = -1;
+        nodes[id].lastEnd = -1;
+        nodes[id].dependencyWait = 0;
+    }
+    enabled = true;
+    return true;
+}
+
+bool dagEnabled() {
+    return enabled;
+}
+
+long dagPriority(unsigned long id) {
+    return priority[id];
+}
+
+pthread_cond_t *dagGrantCond(unsigned long id) {
+    return &nodes[id].grantCond;
+}
+
+bool dagWaitForPredecessors(unsigned long id, unsigned int iteration) {
+    for (unsigned int i = 0; i < taskInfo[id].afterCount; i++) {
+        DAG_NODE &pred = nodes[taskAfter(id)[i]];
+        if (pred.completed.load() >= iteration) {
+            continue; // usually no lock is taken at all
+        }
+        // announce the wait before rechecking, so a completing predecessor either is seen here or
+        // sees the waiter and broadcasts
+        long long start = monotonic_ns();
+        mutex_lock(&pred.mutex);
+        pred.waiters.fetch_add(1);
+        while (pred.completed.load() < iteration && !pred.finished) {
+            cond_wait(&pred.cond, &pred.mutex);
+        }
+        pred.waiters.fetch_sub(1);
+        bool done = pred.completed.load() >= iteration;
+        mutex_unlock(&pred.mutex);
+        nodes[id].dependencyWait += monotonic_ns() - start;
+        if (!done) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void dagComplete(unsigned long id, long long grant, long long end) {
+    DAG_NODE &node = nodes[id];
+    if (node.firstGrant < 0) {
+        node.firstGrant = grant;
+    }
+    node.lastEnd = end;
+    node.completed.fetch_add(1);
+    if (node.waiters.load()) {
+        mutex_lock(&node.mutex);
+        cond_broadcast(&node.cond);
+        mutex_unlock(&node.mutex);
+    }
+}
+
+void dagFinish(unsigned long id) {
+    DAG_NODE &node = nodes[id];
+    mutex_lock(&node.mutex);
+    node.finished = true;
+    cond_broadcast(&node.cond);
+    mutex_unlock(&node.mutex);
+}
+
+std::string getFormattedDagInfo() {
+    if (!enabled) {
+        return "";
+    }
+    std::string info;
+    char buffer[1024];
+
+    std::string path;
+    for (unsigned long i = 0; i < criticalPath.size() && i < MAX_PATH_NAMES; i++) {
+        path.append(i ? " -> " : "").append(taskName(criticalPath[i]));
+    }
+    if (criticalPath.size() > MAX_PATH_NAMES) {
+        path.append(" -> ... -> ").append(taskName(criticalPath.back()));
+    }
+
+    // the makespan ends with the last completed iteration of any task
+    long long makespan = 0;
+    std::vector<long long> stageStart(nStages, -1), stageEnd(nStages, -1);
+    std::vector<unsigned long> stageTasks(nStages, 0), stageIterations(nStages, 0);
+    std::vector<long long> stageDependencyWait(nStages, 0);
+    for (unsigned long id = 0; id < taskInfo.size(); id++) {
+        const DAG_NODE &node = nodes[id];
+        unsigned int s = stage[id];
+        stageTasks[s]++;
+        stageIterations[s] += node.completed.load();
+        stageDependencyWait[s] += node.dependencyWait;
+        if (node.firstGrant >= 0 && (stageStart[s] < 0 || node.firstGrant < stageStart[s])) {
+            stageStart[s] = node.firstGrant;
+        }
+        stageEnd[s] = std::max(stageEnd[s], node.lastEnd);
+        makespan = std::max(makespan, node.lastEnd);
+    }
+
+    // task names are unbounded, so the path is appended rather than formatted into the buffer
+    sprintf(buffer, "Dependencies: %zu tasks in %u stages, critical path= %ld msec per iteration (%zu tasks)\n",
+            taskInfo.size(), nStages, priority[criticalPath[0]], criticalPath.size());
+    info.append(buffer).append("\t ").append(path).append("\n");
+    sprintf(buffer, "\t makespan= %.3f msec\n", makespan / 1e6);
+    info.append(buffer);
+
+    // one line per stage, or only the first and last few of a long pipeline
+    for (unsigned int s = 0; s < nStages; s++) {
+        if (nStages > 2 * MAX_PATH_NAMES && s == MAX_PATH_NAMES) {
+            info.append("\t ...\n");
+            s = nStages - MAX_PATH_NAMES;
+        }
+        double span = (stageEnd[s] - stageStart[s]) / 1e9;
+        char active[64] = "n/a"; // no iteration of the stage completed
+        if (stageStart[s] >= 0) {
+            sprintf(active, "%.3f-%.3f msec", stageStart[s] / 1e6, stageEnd[s] / 1e6);
+        }
+        sprintf(buffer, "\t stage %u: %lu tasks, %lu iterations, %.2f iter/sec (active %s), "
+                        "dependency wait= %.0f msec\n", s,
+                stageTasks[s], stageIterations[s], stageStart[s] >= 0 && span > 0 ? stageIterations[s] / span : 0.0,
+                active, stageDependencyWait[s] / 1e6);
+        info.append(buffer);
+    }
+    return info;
+}
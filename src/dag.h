@@ -0,0 +1,82 @@
+// The following defines the precedence engine for tasks with an "after" clause.
+//
+// A task line may end in `after name1 name2 ...`, meaning iteration k of the task may only start
+// once iteration k of each named task has completed (after its idle period). The tasks and these
+// edges must form a directed acyclic graph.
+//
+// Each task publishes the number of iterations it has completed in an atomic counter. Completing an
+// iteration is one atomic increment, plus a broadcast on the task's condition variable only if a
+// successor is currently blocked on it, so the bookkeeping per completion is O(1) whatever the
+// number of successors. A task about to start iteration k checks the counter of each predecessor
+// and only blocks on the first one that is behind.
+//
+// Resource grants are ordered by critical path: the priority of a task is the length of the
+// longest chain of busy and idle times from the task to the end of the graph, and whenever
+// resources are released the waiting tasks are granted in descending priority order.
+//
+// The stage of a task is the length of the longest chain of predecessors leading to it, so the
+// tasks of a pipeline's n-th step form stage n. Time a task spends blocked on its predecessors is
+// reported per stage as dependency wait; its resource wait only starts once the predecessors are
+// done.
+
+#ifndef DAG_H
+#define DAG_H
+
+#include <pthread.h>
+#include <string>
+
+/**
+ * Checks the dependency graph for cycles and computes the stage and priority of each task.
+ * Exits with EINVAL if the graph has a cycle.
+ * @return false if no task has an "after" clause, in which case the engine stays disabled
+ */
+bool dagInit();
+
+/**
+ * Returns whether tasks have precedence constraints.
+ */
+bool dagEnabled();
+
+/**
+ * Returns the critical path priority of a task; tasks with higher priority are granted first.
+ * @param id index of the task
+ */
+long dagPriority(unsigned long id);
+
+/**
+ * Returns the condition variable a task waits on, with the resource mutex, for its grant.
+ * @param id index of the task
+ */
+pthread_cond_t *dagGrantCond(unsigned long id);
+
+/**
+ * Waits until every predecessor of a task has completed an iteration, adding the time blocked to
+ * the task's dependency wait. Must be called by the task's own thread.
+ * @param id index of the task
+ * @param iteration the iteration the task is about to start, starting at 1
+ * @return false if a predecessor finished running without completing the iteration
+ */
+bool dagWaitForPredecessors(unsigned long id, unsigned int iteration);
+
+/**
+ * Publishes the completion of a task's iteration to its successors. Must be called by the task's
+ * own thread. Times are in nanoseconds since the release of the task threads.
+ * @param id index of the task
+ * @param grant the time the iteration was granted its resources
+ * @param end the time the iteration completed
+ */
+void dagComplete(unsigned long id, long long grant, long long end);
+
+/**
+ * Marks a task as finished, releasing successors waiting for iterations it will not run.
+ * @param id index of the task
+ */
+void dagFinish(unsigned long id);
+
+/**
+ * Formats the critical path, the makespan and the throughput of each stage.
+ * @return the summary, or an empty string if the engine is disabled
+ */
+std::string getFormattedDagInfo();
+
+#endif //DAG_H
@@ -0,0 +1,275 @@
+// This code implements the event log declared in event_log.h.
+
+#include "event_log.h"
+#include "task_manager.h"
+#include "util.h"
+#include "varint.h"
+#include <atomic>
+#include <errno.h>
+#include <memory>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The record of a completed iteration, as queued by a task thread.
+typedef struct {
+    unsigned int iteration;
+    long long waitBegin;
+    long long grant;
+    long long runEnd;
+    long long idleEnd;
+} EVENT_RECORD;
+
+// A single-producer, single-consumer ring of a task's records. The task thread advances `head`
+// and the writer thread advances `tail`, each on a cache line of its own.
+struct alignas(CACHE_LINE_SIZE) EVENT_RING {
+    std::atomic<unsigned long> head; // the number of records pushed, written by the task thread
+    unsigned long dropped; // the number of records dropped on a full ring, written by the task thread
+    alignas(CACHE_LINE_SIZE) std::atomic<unsigned long> tail; // the number of records drained, written by the writer
+};
+
+// A column of a block being encoded.
+typedef struct {
+    std::vector<uint8_t> bytes; // the tokens written so far
+    uint64_t zeros; // the number of zeros since the last token
+} EVENT_COLUMN_BUFFER;
+
+static bool enabled = false; // whether iterations are written to the event log
+static std::string logFileName; // the file the log is written to
+static FILE *logFile = nullptr; // the open log file
+static std::unique_ptr<EVENT_RING[]> rings; // the ring of each task
+static unsigned long ringSize = 0; // the number of slots of each ring, a power of two
+static std::vector<EVENT_RECORD> ringSlots; // ringSize slots per task, by task index
+static std::vector<std::vector<EVENT_RECORD>> staged; // the drained records of each task not written yet
+static unsigned long stagedCount = 0; // the number of staged records
+static unsigned long writtenRecords = 0; // the number of records written
+static unsigned long writtenBlocks = 0; // the number of blocks written
+static unsigned long writtenBytes = 0; // the number of bytes written, including the header
+static bool writeFailed = false; // whether writing the file failed
+
+// Writer thread state, protected by writerMutex
+static pthread_mutex_t writerMutex;
+static pthread_cond_t writerCond; // signalled when the writer thread should stop
+static pthread_t writerThreadID;
+static bool writerRunning = false;
+
+/**
+ * Appends an encoded buffer to the log file
+ * @param buffer the bytes to write
+ */
+static void writeBuffer(const std::vector<uint8_t> &buffer) {
+    if (!writeFailed && fwrite(buffer.data(), 1, buffer.size(), logFile) != buffer.size()) {
+        printf("ERROR: cannot write event log %s: %s\n", logFileName.c_str(), strerror(errno));
+        writeFailed = true;
+    }
+    writtenBytes += buffer.size();
+}
+
+/**
+ * Moves the records queued in every ring to the staging lists
+ */
+static void drainRings() {
+    for (unsigned long id = 0; id < staged.size(); id++) {
+        EVENT_RING &ring = rings[id];
+        unsigned long head = ring.head.load(std::memory_order_acquire);
+        unsigned long tail = ring.tail.load(std::memory_order_relaxed);
+        stagedCount += head - tail;
+        for (; tail != head; tail++) {
+            staged[id].push_back(ringSlots[id * ringSize + (tail & (ringSize - 1))]);
+        }
+        ring.tail.store(tail, std::memory_order_release);
+    }
+}
+
+/**
+ * Writes the pending run of zeros of a column as a token
+ * @param column the column to flush
+ */
+static void flushZeros(EVENT_COLUMN_BUFFER &column) {
+    if (column.zeros) {
+        putVarint(column.bytes, (column.zeros - 1) << 1 | 1);
+        column.zeros = 0;
+    }
+}
+
+/**
+ * Appends a value to a column, folding zeros into runs
+ * @param column the column to append to
+ * @param value the encoded value
+ */
+static void putValue(EVENT_COLUMN_BUFFER &column, uint64_t value) {
+    if (!value) {
+        column.zeros++;
+        return;
+    }
+    flushZeros(column);
+    putVarint(column.bytes, (value - 1) << 1);
+}
+
+/**
+ * Encodes the staged records as one block of columns and writes it
+ */
+static void writeBlock() {
+    if (!stagedCount) {
+        return;
+    }
+    EVENT_COLUMN_BUFFER columns[EVENT_LOG_COLUMNS] = {};
+    int64_t prevTask = 0, prevIteration = 0, prevRun = 0, prevIdle = 0, prevGrant = 0;
+    unsigned long nRecords = 0;
+    for (unsigned long id = 0; id < staged.size(); id++) {
+        for (const EVENT_RECORD &record : staged[id]) {
+            // durations are differences of quantized timestamps, so back-to-back iterations stay exact
+            int64_t waitBegin = record.waitBegin / EVENT_LOG_RESOLUTION_NS;
+            int64_t grant = record.grant / EVENT_LOG_RESOLUTION_NS;
+            int64_t runEnd = record.runEnd / EVENT_LOG_RESOLUTION_NS;
+            int64_t idleEnd = record.idleEnd / EVENT_LOG_RESOLUTION_NS;
+            int64_t wait = grant - waitBegin, run = runEnd - grant, idle = idleEnd - runEnd;
+            int64_t predicted = (int64_t) id == prevTask && nRecords ? prevGrant + prevRun + prevIdle + wait : prevGrant;
+
+            putValue(columns[EVENT_TASK], id - prevTask);
+            putValue(columns[EVENT_ITERATION], zigzag(record.iteration - prevIteration - 1));
+            putValue(columns[EVENT_WAIT], wait);
+            putValue(columns[EVENT_RUN], zigzag(run - prevRun));
+            putValue(columns[EVENT_IDLE], zigzag(idle - prevIdle));
+            putValue(columns[EVENT_GRANT], zigzag(grant - predicted));
+
+            prevTask = id;
+            prevIteration = record.iteration;
+            prevRun = run;
+            prevIdle = idle;
+            prevGrant = grant;
+            nRecords++;
+        }
+        staged[id].clear();
+    }
+
+    std::vector<uint8_t> block;
+    putVarint(block, nRecords);
+    for (EVENT_COLUMN_BUFFER &column : columns) {
+        flushZeros(column);
+        putVarint(block, column.bytes.size());
+        block.insert(block.end(), column.bytes.begin(), column.bytes.end());
+    }
+    writeBuffer(block);
+    writtenRecords += nRecords;
+    writtenBlocks++;
+    stagedCount = 0;
+}
+
+/**
+ * Entry point for the writer thread.
+ * Every EVENT_LOG_FLUSH_MS milliseconds, drains the task rings and writes a block once
+ * EVENT_LOG_BLOCK_RECORDS records are staged. Writes the remaining records and returns once
+ * eventLogClose() is called.
+ * @param arg unused
+ * @return Null pointer
+ */
+static void *writerThread(void *arg) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    for (;;) {
+        deadline.tv_nsec += EVENT_LOG_FLUSH_MS * 1000000L;
+        deadline.tv_sec += deadline.tv_nsec / 1000000000;
+        deadline.tv_nsec %= 1000000000;
+
+        mutex_lock(&writerMutex);
+        while (writerRunning && cond_timedwait(&writerCond, &writerMutex, &deadline)) {
+        }
+        bool running = writerRunning;
+        mutex_unlock(&writerMutex);
+
+        drainRings();
+        if (!running) {
+            writeBlock();
+            return nullptr;
+        }
+        if (stagedCount >= EVENT_LOG_BLOCK_RECORDS) {
+            writeBlock();
+        }
+    }
+}
+
+void eventLogOpen(const std::string &fileName) {
+    logFile = fopen(fileName.c_str(), "wb");
+    if (!logFile) {
+        printf("ERROR: cannot write event log %s: %s\n", fileName.c_str(), strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    logFileName = fileName;
+
+    std::vector<uint8_t> header(EVENT_LOG_MAGIC, EVENT_LOG_MAGIC + strlen(EVENT_LOG_MAGIC));
+    putVarint(header, EVENT_LOG_VERSION);
+    putVarint(header, EVENT_LOG_RESOLUTION_NS);
+    putVarint(header, taskInfo.size());
+    for (unsigned long id = 0; id < taskInfo.size(); id++) {
+        putVarint(header, strlen(taskName(id)));
+        header.insert(header.end(), taskName(id), taskName(id) + strlen(taskName(id)));
+    }
+    writeBuffer(header);
+
+    rings.reset(new EVENT_RING[taskInfo.size()]);
+    for (unsigned long id = 0; id < taskInfo.size(); id++) {
+        rings[id].head.store(0, std::memory_order_relaxed);
+        rings[id].dropped = 0;
+        rings[id].tail.store(0, std::memory_order_relaxed);
+    }
+    ringSize = EVENT_RING_MIN_SIZE;
+    while (ringSize * 2 * taskInfo.size() <= EVENT_RING_BUDGET) {
+        ringSize *= 2;
+    }
+    ringSlots.resize(taskInfo.size() * ringSize);
+    staged.assign(taskInfo.size(), std::vector<EVENT_RECORD>());
+
+    mutex_init(&writerMutex);
+    cond_init(&writerCond);
+    writerRunning = true;
+    writerThreadID = do_pthread_create_with_error_check(writerThread, nullptr);
+    enabled = true;
+}
+
+bool eventLogEnabled() {
+    return enabled;
+}
+
+void eventLogRecord(unsigned long id, unsigned int iteration, long long waitBegin, long long grant, long long runEnd,
+                    long long idleEnd) {
+    EVENT_RING &ring = rings[id];
+    unsigned long head = ring.head.load(std::memory_order_relaxed);
+    if (head - ring.tail.load(std::memory_order_acquire) >= ringSize) {
+        ring.dropped++; // never wait for the writer
+        return;
+    }
+    ringSlots[id * ringSize + (head & (ringSize - 1))] = EVENT_RECORD{iteration, waitBegin, grant, runEnd, idleEnd};
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+void eventLogClose() {
+    if (!enabled) {
+        return;
+    }
+    mutex_lock(&writerMutex);
+    writerRunning = false;
+    cond_broadcast(&writerCond);
+    mutex_unlock(&writerMutex);
+    do_pthread_join_with_error_check(&writerThreadID);
+
+    if (fclose(logFile) && !writeFailed) {
+        printf("ERROR: cannot write event log %s: %s\n", logFileName.c_str(), strerror(errno));
+    }
+}
+
+std::string getFormattedEventLogInfo() {
+    if (!enabled) {
+        return "";
+    }
+    unsigned long dropped = 0;
+    for (unsigned long id = 0; id < staged.size(); id++) {
+        dropped += rings[id].dropped;
+    }
+    char buffer[1024];
+    sprintf(buffer, "Event log: wrote %lu records in %lu blocks, %lu bytes (%.2f bytes/record, dropped= %lu) to %s\n",
+            writtenRecords, writtenBlocks, writtenBytes, writtenRecords ? writtenBytes / (double) writtenRecords : 0.0,
+            dropped, logFileName.c_str());
+    return buffer;
+}
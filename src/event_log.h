@@ -0,0 +1,95 @@
+// The following defines the structured per-iteration event log.
+//
+// Every completed task iteration produces one record: task, iteration, wait, run and idle time,
+// and the time the task was granted its resources. Task threads push records into a ring of their
+// own and never wait: a full ring drops the record and counts it. The rings share a fixed budget of
+// slots, so their memory does not grow with the number of tasks. A background writer thread drains
+// the rings every EVENT_LOG_FLUSH_MS milliseconds and writes them as blocks of columns.
+//
+// File layout (all integers are varints, see varint.h):
+//
+//     "EVLG" version resolutionNs nTasks { nameLength name }*nTasks
+//     { nRecords { nBytes column }*EVENT_LOG_COLUMNS }*
+//
+// Times are stored in ticks of resolutionNs nanoseconds, measured on CLOCK_MONOTONIC from the
+// release of the task threads. The rows of a block are ordered by task, then iteration, and every
+// column is delta-encoded against the previous row:
+//
+//     task        task - previous task
+//     iteration   zigzag(iteration - previous iteration - 1)
+//     wait        wait
+//     run, idle   zigzag(value - previous value)
+//     grant       zigzag(grant - (previous grant + previous run + previous idle + wait)) after a row
+//                 of the same task, whose iterations are back to back so this is usually 0, and
+//                 zigzag(grant - previous grant) otherwise
+//
+// The first row of a block is encoded against a row of zeros. Most rows then encode 0 in the task,
+// iteration and grant columns, so each column stores runs of zeros as a single token: a varint x
+// stands for (x >> 1) + 1 zeros if it is odd, and for the value (x >> 1) + 1 if it is even.
+// tools/evlog2csv.cpp converts a log to CSV.
+
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <string>
+
+// Define the identification of the event log format.
+#define EVENT_LOG_MAGIC "EVLG"
+#define EVENT_LOG_VERSION 1
+
+// Define the resolution times are stored at, in nanoseconds.
+#define EVENT_LOG_RESOLUTION_NS 1000
+
+// Define the columns of a block, in the order they are stored.
+typedef enum {
+    EVENT_TASK, EVENT_ITERATION, EVENT_WAIT, EVENT_RUN, EVENT_IDLE, EVENT_GRANT
+} EVENT_COLUMN;
+#define EVENT_LOG_COLUMNS 6
+
+// Define the number of records all rings hold together, and the fewest a single ring holds. Each
+// ring gets the budget divided by the number of tasks, rounded down to a power of two.
+#define EVENT_RING_BUDGET (1L << 18)
+#define EVENT_RING_MIN_SIZE 64
+
+// Define the interval the writer thread drains the rings at, in milliseconds.
+#define EVENT_LOG_FLUSH_MS 50
+
+// Define the number of drained records at which the writer writes a block.
+#define EVENT_LOG_BLOCK_RECORDS 16384
+
+/**
+ * Writes the file header and starts the writer thread.
+ * @param fileName the file to write the log to
+ */
+void eventLogOpen(const std::string &fileName);
+
+/**
+ * Returns whether iterations are written to the event log.
+ */
+bool eventLogEnabled();
+
+/**
+ * Queues the record of a completed iteration for the writer thread, without blocking. Must be
+ * called by the task's own thread. Times are in nanoseconds since the release of the task threads.
+ * @param id index of the task
+ * @param iteration the number of the iteration, starting at 1
+ * @param waitBegin the time the task started waiting for its resources
+ * @param grant the time the task was granted its resources
+ * @param runEnd the time the task released its resources
+ * @param idleEnd the time the task's idle period ended
+ */
+void eventLogRecord(unsigned long id, unsigned int iteration, long long waitBegin, long long grant, long long runEnd,
+                    long long idleEnd);
+
+/**
+ * Stops the writer thread once it has written every queued record, and closes the file.
+ */
+void eventLogClose();
+
+/**
+ * Formats a summary of the written log for the termination report.
+ * @return the summary, or an empty string if the event log is disabled
+ */
+std::string getFormattedEventLogInfo();
+
+#endif //EVENT_LOG_H
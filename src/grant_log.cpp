@@ -0,0 +1,157 @@
+// This code implements the grant log declared in grant_log.h.
+
+#include "grant_log.h"
+#include "task_manager.h"
+#include "varint.h"
+#include <algorithm>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Define an enum for the modes of the grant log.
+typedef enum {
+    GRANT_LOG_OFF, GRANT_LOG_RECORD, GRANT_LOG_REPLAY
+} GRANT_LOG_MODE;
+
+static GRANT_LOG_MODE mode = GRANT_LOG_OFF; // what the grant log is doing
+static std::string logFileName; // the file the log is written to or read from
+static std::vector<uint8_t> recorded; // the varint-encoded events recorded so far
+static unsigned long recordedEvents = 0; // the number of events recorded so far
+static std::vector<unsigned int> replayGrants; // the replayed grant order, by task index
+static std::vector<unsigned int> replayReleases; // the replayed release order, by task index
+static std::vector<char> replayFinished; // whether a task stopped running, by task index
+static unsigned long grantCursor = 0; // the number of replayed grants made or skipped so far
+static unsigned long skippedGrants = 0; // the number of replayed grants skipped for stopped tasks
+static unsigned long releaseCursor = 0; // the number of releases made so far while replaying
+static unsigned long releaseDivergences = 0; // the number of releases that differed from the log
+
+void grantLogRecordOpen(const std::string &fileName, unsigned long iterations) {
+    mode = GRANT_LOG_RECORD;
+    logFileName = fileName;
+    recorded.assign(GRANT_LOG_MAGIC, GRANT_LOG_MAGIC + strlen(GRANT_LOG_MAGIC));
+    putVarint(recorded, GRANT_LOG_VERSION);
+    putVarint(recorded, taskInfo.size());
+    putVarint(recorded, resourceNames.size());
+    putVarint(recorded, iterations);
+}
+
+void grantLogReplayOpen(const std::string &fileName, unsigned long iterations) {
+    FILE *file = fopen(fileName.c_str(), "rb");
+    if (!file) {
+        printf("ERROR: cannot read grant log %s: %s\n", fileName.c_str(), strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    std::vector<uint8_t> buffer;
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        buffer.insert(buffer.end(), chunk, chunk + n);
+    }
+    fclose(file);
+
+    unsigned long pos = strlen(GRANT_LOG_MAGIC);
+    uint64_t version, nTasks, nResources, nIterations, event;
+    if (buffer.size() < pos || memcmp(buffer.data(), GRANT_LOG_MAGIC, pos) != 0 ||
+        !getVarint(buffer, pos, version) || version != GRANT_LOG_VERSION ||
+        !getVarint(buffer, pos, nTasks) || !getVarint(buffer, pos, nResources) ||
+        !getVarint(buffer, pos, nIterations)) {
+        printf("ERROR: %s is not a grant log\n", fileName.c_str());
+        exit(EXIT_FAILURE);
+    }
+    if (nTasks != taskInfo.size() || nResources != resourceNames.size()) {
+        printf("ERROR: grant log %s was recorded with %lu tasks and %lu resource types\n", fileName.c_str(),
+               (unsigned long) nTasks, (unsigned long) nResources);
+        exit(EXIT_FAILURE);
+    }
+    if (nIterations != iterations) {
+        printf("ERROR: grant log %s was recorded with %lu iterations\n", fileName.c_str(),
+               (unsigned long) nIterations);
+        exit(EXIT_FAILURE);
+    }
+    while (pos < buffer.size()) {
+        if (!getVarint(buffer, pos, event) || (event >> 1) >= nTasks) {
+            printf("ERROR: grant log %s is corrupt\n", fileName.c_str());
+            exit(EXIT_FAILURE);
+        }
+        (event & 1 ? replayReleases : replayGrants).push_back(event >> 1);
+    }
+
+    replayFinished.assign(nTasks, false);
+    mode = GRANT_LOG_REPLAY;
+    logFileName = fileName;
+}
+
+/**
+ * Advances the replay past the grants of tasks that stopped running
+ */
+static void skipFinished() {
+    while (grantCursor < replayGrants.size() && replayFinished[replayGrants[grantCursor]]) {
+        grantCursor++;
+        skippedGrants++;
+    }
+}
+
+bool grantLogReplaying() {
+    return mode == GRANT_LOG_REPLAY;
+}
+
+bool grantLogIsTurn(unsigned long id) {
+    return mode != GRANT_LOG_REPLAY || grantCursor >= replayGrants.size() || replayGrants[grantCursor] == id;
+}
+
+void grantLogGrant(unsigned long id) {
+    if (mode == GRANT_LOG_RECORD) {
+        putVarint(recorded, id << 1);
+        recordedEvents++;
+    } else if (mode == GRANT_LOG_REPLAY) {
+        grantCursor++;
+        skipFinished();
+    }
+}
+
+void grantLogRelease(unsigned long id) {
+    if (mode == GRANT_LOG_RECORD) {
+        putVarint(recorded, id << 1 | 1);
+        recordedEvents++;
+    } else if (mode == GRANT_LOG_REPLAY) {
+        if (releaseCursor >= replayReleases.size() || replayReleases[releaseCursor] != id) {
+            releaseDivergences++;
+        }
+        releaseCursor++;
+    }
+}
+
+void grantLogFinish(unsigned long id) {
+    if (mode == GRANT_LOG_REPLAY) {
+        replayFinished[id] = true;
+        skipFinished();
+    }
+}
+
+void grantLogClose() {
+    if (mode != GRANT_LOG_RECORD) {
+        return;
+    }
+    FILE *file = fopen(logFileName.c_str(), "wb");
+    if (!file || fwrite(recorded.data(), 1, recorded.size(), file) != recorded.size() || fclose(file)) {
+        printf("ERROR: cannot write grant log %s: %s\n", logFileName.c_str(), strerror(errno));
+    }
+}
+
+std::string getFormattedGrantLogInfo() {
+    char buffer[1024];
+    if (mode == GRANT_LOG_RECORD) {
+        sprintf(buffer, "Grant log: recorded %lu events in %zu bytes to %s\n", recordedEvents, recorded.size(),
+                logFileName.c_str());
+    } else if (mode == GRANT_LOG_REPLAY) {
+        sprintf(buffer, "Grant log: replayed %lu of %zu grants from %s "
+                        "(skipped= %lu, release order divergences= %lu)\n",
+                std::min<unsigned long>(grantCursor, replayGrants.size()) - skippedGrants, replayGrants.size(),
+                logFileName.c_str(), skippedGrants, releaseDivergences);
+    } else {
+        return "";
+    }
+    return buffer;
+}
@@ -0,0 +1,83 @@
+// The following defines the grant log used to record and replay the order of resource grants.
+//
+// In record mode every grant and release decision made under the resource mutex is appended to an
+// in-memory log, which is written to a file at termination. The file starts with the magic bytes
+// "GRLG" followed by varints of the format version, the number of tasks, the number of resource
+// types and the number of iterations per task; every event after that is a single varint holding
+// (task index << 1) | isRelease.
+//
+// In replay mode the log is read back and a task is only granted its resources when it is the next
+// task to be granted in the log, so allocator changes can be compared on an identical grant order
+// while tasks still run on real threads with real timings. Once the log is exhausted, grants are
+// made freely again. When a task stops running, its remaining grants in the log are skipped, so it
+// cannot hold up the tasks after it.
+
+#ifndef GRANT_LOG_H
+#define GRANT_LOG_H
+
+#include <string>
+
+// Define the identification of the grant log format.
+#define GRANT_LOG_MAGIC "GRLG"
+#define GRANT_LOG_VERSION 2
+
+/**
+ * Starts recording grants, to be written to `fileName` by grantLogClose().
+ * @param fileName the file to write the log to
+ * @param iterations the number of iterations each task runs
+ */
+void grantLogRecordOpen(const std::string &fileName, unsigned long iterations);
+
+/**
+ * Reads a recorded log and starts replaying its grant order. Exits if the log was recorded with
+ * different tasks, resource types or iterations.
+ * @param fileName the file to read the log from
+ * @param iterations the number of iterations each task runs
+ */
+void grantLogReplayOpen(const std::string &fileName, unsigned long iterations);
+
+/**
+ * Returns whether a grant order is being replayed.
+ */
+bool grantLogReplaying();
+
+/**
+ * Returns whether a task may be granted its resources now, i.e. it is the next grant in the
+ * replayed log, or no log is being replayed. Must be called with the resource mutex held.
+ * @param id index of the task
+ */
+bool grantLogIsTurn(unsigned long id);
+
+/**
+ * Records, or advances the replay past, the grant of a task's resources. Must be called with the
+ * resource mutex held.
+ * @param id index of the task
+ */
+void grantLogGrant(unsigned long id);
+
+/**
+ * Records, or checks against the replayed log, the release of a task's resources. Must be called
+ * with the resource mutex held.
+ * @param id index of the task
+ */
+void grantLogRelease(unsigned long id);
+
+/**
+ * Marks a task as stopped, skipping its remaining grants in the replayed log. Must be called with
+ * the resource mutex held.
+ * @param id index of the task
+ */
+void grantLogFinish(unsigned long id);
+
+/**
+ * Writes the recorded log to its file, if recording.
+ */
+void grantLogClose();
+
+/**
+ * Formats a summary of the recorded or replayed log for the termination report.
+ * @return the summary, or an empty string if neither recording nor replaying
+ */
+std::string getFormattedGrantLogInfo();
+
+#endif //GRANT_LOG_H
@@ -6,13 +6,169 @@
 #include <iterator>
 #include <map>
 #include <stdlib.h>
+#include "atomic_alloc.h"
+#include "busy.h"
 #include "parsers.h"
+#include "shard.h"
 #include "task.h"
 #include "task_manager.h"
 
 
 using namespace std;
 
+// The names of the predecessors in taskAfterArena, resolved to task indices once the whole file is read.
+static vector<string> taskAfterNames;
+
+/**
+ * Returns the default values of the optional command line arguments
+ * @return {@code CommandLineArguments} args with only the optional fields set
+ */
+CommandLineArguments default_arguments() {
+    CommandLineArguments args;
+    args.monitorTime = 0;
+    args.iterations = 0;
+    args.snapshotEvery = 0;
+    args.profileTop = 0;
+    args.shards = 0;
+    args.transport = SHM_TRANSPORT;
+    args.allocator = AUTO_ALLOCATOR;
+    args.busyMode = SLEEP_BUSY;
+    args.duration = 0;
+    args.warmup = 0;
+    return args;
+}
+
+/**
+ * Applies an optional `--name value` command line argument
+ * @param name - the option name, without the leading "--"
+ * @param value - the option value
+ * @param args - the arguments to update
+ * @return 0 on a valid option or an error code
+ */
+int parse_option(const string &name, const char *value, CommandLineArguments *args) {
+    if (name == "snapshot-every") {
+        args->snapshotEvery = atol(value);
+        if (args->snapshotEvery < 0) {
+            printf("snapshot-every invalid\n");
+            return EINVAL;
+        }
+        return 0;
+    }
+
+    if (name == "profile") {
+        args->profileTop = atol(value);
+        if (args->profileTop < 0) {
+            printf("profile invalid\n");
+            return EINVAL;
+        }
+        return 0;
+    }
+
+    if (name == "profile-csv") {
+        args->profileCsv = value;
+        if (!args->profileTop) {
+            args->profileTop = DEFAULT_PROFILE_TOP;
+        }
+        return 0;
+    }
+
+    if (name == "shards") {
+        args->shards = atoi(value);
+        if (args->shards < 0 || args->shards > MAX_SHARDS) {
+            printf("shards invalid\n");
+            return EINVAL;
+        }
+        return 0;
+    }
+
+    if (name == "transport") {
+        args->transport = value;
+        if (args->transport != SHM_TRANSPORT && args->transport != SOCKET_TRANSPORT) {
+            printf("transport invalid\n");
+            return EINVAL;
+        }
+        return 0;
+    }
+
+    if (name == "shm-state") {
+        args->shmState = value;
+        if (args->shmState.empty() || args->shmState.find('/', 1) != string::npos) {
+            printf("shm-state invalid\n");
+            return EINVAL;
+        }
+        if (args->shmState[0] != '/') {
+            args->shmState.insert(0, "/");
+        }
+        return 0;
+    }
+
+    if (name == "record" || name == "replay") {
+        (name == "record" ? args->recordFile : args->replayFile) = value;
+        if (!args->recordFile.empty() && !args->replayFile.empty()) {
+            printf("record and replay are exclusive\n");
+            return EINVAL;
+        }
+        return 0;
+    }
+
+    if (name == "events") {
+        args->eventsFile = value;
+        return 0;
+    }
+
+    if (name == "duration" || name == "warmup") {
+        (name == "duration" ? args->duration : args->warmup) = atol(value);
+        if (args->duration < 0 || args->warmup < 0) {
+            printf("%s invalid\n", name.c_str());
+            return EINVAL;
+        }
+        return 0;
+    }
+
+    if (name == "busy") {
+        args->busyMode = value;
+        if (args->busyMode != SLEEP_BUSY && args->busyMode != CPU_BUSY && args->busyMode != MEMORY_BUSY) {
+            printf("busy invalid\n");
+            return EINVAL;
+        }
+        return 0;
+    }
+
+    if (name == "allocator") {
+        args->allocator = value;
+        if (args->allocator != AUTO_ALLOCATOR && args->allocator != ATOMIC_ALLOCATOR &&
+            args->allocator != MUTEX_ALLOCATOR) {
+            printf("allocator invalid\n");
+            return EINVAL;
+        }
+        return 0;
+    }
+
+    printf("Unknown option: %s%s\n", OPTION_PREFIX, name.c_str());
+    return EINVAL;
+}
+
+/**
+ * Applies every optional argument following the positional arguments
+ * @param argumentCount
+ * @param argumentValues
+ * @param args - the arguments to update
+ * @return 0 on valid options or an error code
+ */
+int parse_options(int argumentCount, char *argumentValues[], CommandLineArguments *args) {
+    for (int i = 4; i < argumentCount; i += 2) {
+        if (strncmp(argumentValues[i], OPTION_PREFIX, strlen(OPTION_PREFIX)) != 0 || i + 1 >= argumentCount) {
+            printf("Invalid option: %s\n", argumentValues[i]);
+            return EINVAL;
+        }
+        int status = parse_option(argumentValues[i] + strlen(OPTION_PREFIX), argumentValues[i + 1], args);
+        if (status) {
+            return status;
+        }
+    }
+    return 0;
+}
+
 /**
  * Checks for proper command line arguments and returns 0 on valid
  * args or an error code
@@ -21,7 +177,7 @@ using namespace std;
  * @return status
  */
 int args_check(int argumentCount, char *argumentValues[]) {
-    if (argumentCount != 4) {
+    if (argumentCount < 4) {
         printf("Invalid number of arguments.\n");
         return EINVAL;
     }
@@ -39,7 +195,8 @@ int args_check(int argumentCount, char *argumentValues[]) {
         return EINVAL;
     }
 
-    return 0;
+    CommandLineArguments args = default_arguments();
+    return parse_options(argumentCount, argumentValues, &args);
 }
 
 /**
@@ -49,10 +206,11 @@ int args_check(int argumentCount, char *argumentValues[]) {
  * @return {@code CommandLineArguments} args
  */
 CommandLineArguments parse_arguments(int argumentCount, char *argumentValues[]) {
-    CommandLineArguments args;
+    CommandLineArguments args = default_arguments();
     args.inputFileName = argumentValues[1];
     args.monitorTime = (atoi(argumentValues[2]));
     args.iterations = (atoi(argumentValues[3]));
+    parse_options(argumentCount, argumentValues, &args);
     return args;
 }
 
@@ -64,13 +222,13 @@ std::string getFormattedResourceInfo() {
     std::map<string, int>::iterator itr;
     std::string systemResources;
 
-    // Iterates over the resource map and appends each resource's information to the output string
-    for (itr = resourceMap.begin(); itr != resourceMap.end(); itr++) {
+    // Iterates over the resource index and appends each resource's information to the output string
+    for (itr = resourceIndex.begin(); itr != resourceIndex.end(); itr++) {
         char buffer[MAX_RESOURCE_LENGTH];
 
         // Formats the resource information using the iterator
-        int val = sprintf(buffer, "\t%s: (maxAvail=   %i, held=   0) \n", (itr->first).c_str(),
-                          resourceMap[itr->first]);
+        int val = sprintf(buffer, "\t%s: (maxAvail=   %i, held=   %i) \n", (itr->first).c_str(),
+                          resourceMaxAvail[itr->second], resourceMaxAvail[itr->second] - resourceAvail[itr->second]);
 
         // Checks if formatting was successful, and exits the program if not
         if (!val) {
@@ -103,22 +261,14 @@ void convertStatus(STATUS tStatus, char *status) {
 
 /**
     Generates a formatted string with information about a system task's resource usage
-    @param reqResource The resource string specifying the required resource and quantity
+    @param req The resource requirement of the task
+    @param status The status of the task, which holds its resources only while running
     @param buffer The output buffer for the generated formatted string
     */
-void getFormattedSystemTaskResourceInfo(std::string reqResource, char* buffer) {
-  char *saveptr;
-  char *resourceName;
-  int resourcesNeeded;
-  char resourceString[MAX_RESOURCE_LENGTH];
-
-  // Converts the input string to a C-style string and extracts the resource name and quantity
-  strcpy(resourceString, reqResource.c_str());
-  resourceName = strtok_r(resourceString, ":", &saveptr);
-  resourcesNeeded = atoi(strtok_r(nullptr, ":", &saveptr));
-  
-  // Formats the resource information using the extracted values
-  sprintf(buffer, "\t %s: (needed=\t%d, held= 0)\n", resourceName, resourcesNeeded);
+void getFormattedSystemTaskResourceInfo(const RESOURCE_REQ &req, STATUS status, char* buffer) {
+  // Formats the resource information using the requirement's resource name and quantity
+  sprintf(buffer, "\t %s: (needed=\t%d, held= %d)\n", resourceNames[req.resource].c_str(), req.units,
+          status == RUN ? req.units : 0);
 }
 
 /**
@@ -129,17 +279,17 @@ std::string getFormattedTaskInfo() {
     std::string systemTasks;
 
     // iterate over each task in the task list
-    for (unsigned int i = 0; i < taskList.size(); i++) {
+    for (unsigned int i = 0; i < taskInfo.size(); i++) {
         char buffer[1024];
         char status[MAX_RESOURCE_LENGTH];
 
         // get the task status and convert it to a string
-        convertStatus(taskList.at(i).status, status);
+        convertStatus(taskState.at(i).status, status);
 
         // create a formatted string with task information
         sprintf(buffer, "[%d] %s (%s, runTime= %i msec, idleTime= %i msec):\n", i,
-                taskList.at(i).name, status,
-                taskList.at(i).busyTime, taskList.at(i).idleTime);
+                taskName(i), status,
+                taskInfo.at(i).busyTime, taskInfo.at(i).idleTime);
 
         // append task information to the systemTasks string
         systemTasks.append(buffer);
@@ -149,24 +299,44 @@ std::string getFormattedTaskInfo() {
         systemTasks.append(buffer);
 
         // iterate over each required resource for the task
-        for (auto &reqResource : taskList.at(i).reqResources) {
+        for (unsigned int r = 0; r < taskInfo.at(i).reqCount; r++) {
             char resBuffer[1024];
 
             // create a formatted string with the required resource info and append it to the systemTasks string
-            getFormattedSystemTaskResourceInfo(reqResource, resBuffer);
+            getFormattedSystemTaskResourceInfo(taskReqs(i)[r], taskState.at(i).status, resBuffer);
             systemTasks.append(resBuffer);
         }
 
         // create a formatted string with the task execution and wait times and append it to the systemTasks string
-        sprintf(buffer, "\t (RUN: %d times, WAIT: %lu msec)\n\n", taskList.at(i).timesExecuted,
-                taskList.at(i).totalWaitTime);
+        sprintf(buffer, "\t (RUN: %d times, WAIT: %lu msec)\n\n", taskState.at(i).timesExecuted,
+                taskState.at(i).totalWaitTime);
         systemTasks.append(buffer);
     }
     return systemTasks;
 }
 
 /**
- * Add a resource to the resource map
+ * Returns the index of a resource type in the resource tables, registering it
+ * with no available units if it has not been seen yet
+ * @param name - the name of the resource type
+ * @return the index of the resource type
+ */
+int getResourceIndex(const string &name) {
+    auto itr = resourceIndex.find(name);
+    if (itr != resourceIndex.end()) {
+        return itr->second;
+    }
+
+    int index = (int) resourceNames.size();
+    resourceIndex[name] = index;
+    resourceNames.push_back(name);
+    resourceAvail.push_back(0);
+    resourceMaxAvail.push_back(0);
+    return index;
+}
+
+/**
+ * Add a resource to the resource tables
  * @param arg - a string containing the resource name and value pair
  */
 void parseResourceArg(const string &arg) {
@@ -181,8 +351,10 @@ void parseResourceArg(const string &arg) {
     string name(strtok_r(nameValuePair, ":", &saveptr));
     number = atoi(strtok_r(nullptr, ":", &saveptr));
 
-    // add the resource to the resource map
-    resourceMap[name] = number;
+    // add the resource to the resource tables
+    int index = getResourceIndex(name);
+    resourceAvail[index] = number;
+    resourceMaxAvail[index] = number;
 }
 
 /**
@@ -220,37 +392,73 @@ void parseResourcesLine(const string &line) {
     */
 void parseTaskLine(const string &line) {
     // convert line string to a C-style string
-    char cline[100];
-    strcpy(cline, line.c_str());
+    vector<char> buffer(line.c_str(), line.c_str() + line.size() + 1);
+    char *cline = buffer.data();
 
     // use strtok_r to split the string into its components
     char *saveptr;
     char *token;
     token = strtok_r(cline, " ", &saveptr); // flag
     token = strtok_r(nullptr, " ", &saveptr); // id
-    TASK newTask;
-    newTask.status = IDLE;
-    newTask.totalIdleTime = 0;
-    newTask.totalBusyTime = 0;
-    newTask.totalWaitTime = 0;
-    newTask.timesExecuted = 0;
-    strcpy(newTask.name, token);
+    if (strlen(token) > MAX_NAME_LENGTH) {
+    printf("ERROR: TASK NAME LONGER THAN %d CHARACTERS: %s\n", MAX_NAME_LENGTH, token);
+    exit(EINVAL);
+    }
+    TASK_INFO newTask;
+    newTask.nameOffset = taskNameArena.size();
+    taskNameArena.append(token);
+    taskNameArena.push_back('\0');
     token = strtok_r(nullptr, " ", &saveptr); // busy
     newTask.busyTime = atoi(token);
     token = strtok_r(nullptr, " ", &saveptr); // idle
     newTask.idleTime = atoi(token);
 
-    // parse resource requirements
+    // parse resource requirements into the requirement arena
     token = strtok_r(nullptr, " ", &saveptr);
-    newTask.assigned = false;
-    while (token != nullptr) {
-    string str(token);
-    newTask.reqResources.push_back(str);
+    newTask.reqOffset = taskReqArena.size();
+    newTask.reqCount = 0;
+    while (token != nullptr && strcmp(token, AFTER_FLAG) != 0) {
+    char *reqSaveptr;
+    RESOURCE_REQ req;
+    req.resource = getResourceIndex(strtok_r(token, ":", &reqSaveptr));
+    req.units = atoi(strtok_r(nullptr, ":", &reqSaveptr));
+    taskReqArena.push_back(req);
+    newTask.reqCount++;
     token = strtok_r(nullptr, " ", &saveptr);
     }
 
-    // add new task to the task list
-    taskList.push_back(newTask);
+    // parse the optional "after" clause into the predecessor arena, by name until the file is read
+    newTask.afterOffset = taskAfterArena.size();
+    newTask.afterCount = 0;
+    while (token != nullptr && (token = strtok_r(nullptr, " ", &saveptr)) != nullptr) {
+    taskAfterArena.push_back(0);
+    taskAfterNames.push_back(token);
+    newTask.afterCount++;
+    }
+
+    // add new task to the task tables
+    TASK_STATE newState = TASK_STATE();
+    newState.status = IDLE;
+    taskInfo.push_back(newTask);
+    taskState.push_back(newState);
+    }
+
+/**
+    Resolves the predecessor names of every task's "after" clause to task indices
+    */
+void resolveTaskDependencies() {
+    map<string, unsigned int> taskIndex;
+    for (unsigned int id = 0; id < taskInfo.size(); id++) {
+    taskIndex[taskName(id)] = id;
+    }
+    for (unsigned long i = 0; i < taskAfterNames.size(); i++) {
+    auto itr = taskIndex.find(taskAfterNames[i]);
+    if (itr == taskIndex.end()) {
+    printf("ERROR: UNKNOWN TASK IN AFTER CLAUSE: %s\n", taskAfterNames[i].c_str());
+    exit(EINVAL);
+    }
+    taskAfterArena[i] = itr->second;
+    }
     }
 
 /**
@@ -330,4 +538,5 @@ void parseInputFileLine(const string& line) {
     }
 
     file.close(); // close the file stream after use
+    resolveTaskDependencies();
     }
\ No newline at end of file
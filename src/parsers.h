@@ -14,14 +14,24 @@
 #define RESOURCE_FLAG "resources"
 #define TASK_FLAG "task"
 #define COMMENT_FLAG "#"
+#define AFTER_FLAG "after"
 
 #define RUN_FLAG "RUN"
 #define IDLE_FLAG "IDLE"
 #define WAIT_FLAG "WAIT"
 
+// Define the prefix of optional command line flags.
+#define OPTION_PREFIX "--"
+
+// Define the number of entries the contention profiler reports when only a CSV file is requested.
+#define DEFAULT_PROFILE_TOP 5
+
 // Define a constant for the maximum length of a resource string.
 #define MAX_RESOURCE_LENGTH 64
 
+// Define a constant for the maximum length of a task name, which the reports format into fixed buffers.
+#define MAX_NAME_LENGTH 32
+
 // Use the following namespaces.
 using std::string;
 using std::vector;
@@ -38,11 +48,25 @@ typedef struct
 		string inputFileName; // The name of the input file.
 		long monitorTime; // The time interval between system monitoring.
 		uint iterations; // The number of iterations for which the system will be monitored.
+		long snapshotEvery; // Print a full monitor snapshot every this many monitor ticks (0 = never).
+		long profileTop; // Number of bottleneck resources and blocking pairs to report (0 = profiler off).
+		string profileCsv; // File to write the contention profile to as CSV (empty = none).
+		int shards; // Number of shard processes to partition the simulation across (0 = single process).
+		string transport; // Transport carrying requests between shards ("shm" or "socket").
+		string shmState; // POSIX shared memory name to publish the live state under (empty = none).
+		string recordFile; // File to record the grant order to (empty = none).
+		string replayFile; // File to replay the grant order from (empty = none).
+		string eventsFile; // File to write the per-iteration event log to (empty = none).
+		long duration; // Run every task until this many milliseconds have passed instead of NITER times (0 = off).
+		long warmup; // Exclude this many milliseconds at the start of a fixed-duration run from the statistics.
+		string busyMode; // How tasks spend their busy time ("sleep", "cpu" or "memory").
+		string allocator; // Allocator granting resources ("auto", "atomic" or "mutex").
 } CommandLineArguments;
 
 // Declare functions that will be defined later.
 string getFormattedResourceInfo();
 string getFormattedTaskInfo();
+int parse_option(const string &name, const char *value, CommandLineArguments *args);
 int args_check(int argumentCount, char *argumentValues[]);
 CommandLineArguments parse_arguments(int argumentCount, char *argumentValues[]);
 void readInputFile(const string &inputFileName);
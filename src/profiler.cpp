@@ -0,0 +1,277 @@
+// This code implements the resource contention profiler declared in profiler.h.
+
+#include "profiler.h"
+#include "task_manager.h"
+#include "util.h"
+#include <algorithm>
+#include <map>
+#include <tuple>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Define an enum for the kinds of recorded events.
+typedef enum {
+    PROFILE_WAIT, PROFILE_GRANT, PROFILE_RELEASE
+} PROFILE_EVENT_TYPE;
+
+// A single recorded event.
+typedef struct {
+    long long time; // CLOCK_MONOTONIC time of the event in nanoseconds
+    unsigned int task; // index of the task the event belongs to
+    PROFILE_EVENT_TYPE type; // the kind of event
+} PROFILE_EVENT;
+
+// The event buffer of a task, appended to by the task's own thread, or by the thread granting the
+// task's resources while the task waits for them.
+struct alignas(CACHE_LINE_SIZE) PROFILE_BUFFER {
+    std::vector<PROFILE_EVENT> events;
+};
+
+// A blocking pair: (waiting task, holding task, resource).
+typedef std::tuple<unsigned long, unsigned long, int> BLAME_KEY;
+
+// The statistics derived from the recorded events.
+typedef struct {
+    long long duration; // time between the first and last event in nanoseconds
+    std::vector<double> heldTime; // integral of held units over time, per resource
+    std::vector<double> queueTime; // integral of waiting tasks over time, per resource
+    std::vector<long long> blockedTime; // total time tasks waited while too few units were free, per resource
+    std::vector<std::vector<double>> heldBuckets; // held unit-time per PROFILE_BUCKET_MS bucket, per resource
+    std::vector<std::vector<double>> queueBuckets; // waiting task-time per PROFILE_BUCKET_MS bucket, per resource
+    std::map<BLAME_KEY, long long> blame; // time each task waited while another held units it lacked
+} PROFILE;
+
+static bool enabled = false; // whether events are being recorded
+static std::vector<PROFILE_BUFFER> buffers; // one event buffer per task
+
+void profilerInit(unsigned long nTasks, unsigned long iterations) {
+    enabled = true;
+    buffers.resize(nTasks);
+    for (auto &buffer : buffers) {
+        buffer.events.reserve(3 * iterations);
+    }
+}
+
+bool profilerEnabled() {
+    return enabled;
+}
+
+/**
+ * Appends an event to a task's buffer
+ * @param id index of the task
+ * @param type the kind of event
+ */
+static void record(unsigned long id, PROFILE_EVENT_TYPE type) {
+    if (!enabled) {
+        return;
+    }
+    PROFILE_EVENT event;
+    event.time = monotonic_ns();
+    event.task = id;
+    event.type = type;
+    buffers[id].events.push_back(event);
+}
+
+void profileWaitBegin(unsigned long id) {
+    record(id, PROFILE_WAIT);
+}
+
+void profileGrant(unsigned long id) {
+    record(id, PROFILE_GRANT);
+}
+
+void profileRelease(unsigned long id) {
+    record(id, PROFILE_RELEASE);
+}
+
+/**
+ * Spreads `value` per nanosecond over the buckets covering [start, end)
+ * @param buckets the bucket series to add to
+ * @param start the start of the interval, relative to the first event
+ * @param end the end of the interval, relative to the first event
+ * @param value the amount to add per nanosecond
+ */
+static void addToBuckets(std::vector<double> &buckets, long long start, long long end, double value) {
+    const long long width = PROFILE_BUCKET_MS * 1000000LL;
+    while (start < end) {
+        long long bucket = start / width;
+        long long bucketEnd = std::min(end, (bucket + 1) * width);
+        if ((long long) buckets.size() <= bucket) {
+            buckets.resize(bucket + 1, 0);
+        }
+        buckets[bucket] += value * (bucketEnd - start);
+        start = bucketEnd;
+    }
+}
+
+/**
+ * Merges the task buffers by time and replays them, integrating resource usage, queue depth and
+ * blocking time between consecutive events
+ * @return the derived statistics
+ */
+static PROFILE buildProfile() {
+    std::vector<PROFILE_EVENT> events;
+    for (auto &buffer : buffers) {
+        events.insert(events.end(), buffer.events.begin(), buffer.events.end());
+    }
+    std::stable_sort(events.begin(), events.end(), [](const PROFILE_EVENT &a, const PROFILE_EVENT &b) {
+        return a.time < b.time;
+    });
+
+    unsigned long nRes = resourceNames.size();
+    PROFILE profile;
+    profile.duration = events.empty() ? 0 : events.back().time - events.front().time;
+    profile.heldTime.assign(nRes, 0);
+    profile.queueTime.assign(nRes, 0);
+    profile.blockedTime.assign(nRes, 0);
+    profile.heldBuckets.resize(nRes);
+    profile.queueBuckets.resize(nRes);
+
+    std::vector<int> held(nRes, 0); // units currently held, per resource
+    std::vector<int> queued(nRes, 0); // tasks currently waiting, per resource
+    std::vector<std::vector<unsigned long>> holders(nRes); // tasks currently holding, per resource
+    std::vector<unsigned long> waiters; // tasks currently waiting
+    long long prev = events.empty() ? 0 : events.front().time;
+
+    for (auto &event : events) {
+        long long dt = event.time - prev;
+        if (dt > 0) {
+            long long start = prev - events.front().time;
+            for (unsigned long r = 0; r < nRes; r++) {
+                profile.heldTime[r] += (double) held[r] * dt;
+                profile.queueTime[r] += (double) queued[r] * dt;
+                if (held[r]) {
+                    addToBuckets(profile.heldBuckets[r], start, start + dt, held[r]);
+                }
+                if (queued[r]) {
+                    addToBuckets(profile.queueBuckets[r], start, start + dt, queued[r]);
+                }
+            }
+            // blame the holders of each resource a waiting task needs, but only while too few of
+            // its units are free for the waiter
+            for (unsigned long waiter : waiters) {
+                for (unsigned int i = 0; i < taskInfo[waiter].reqCount; i++) {
+                    int r = taskReqs(waiter)[i].resource;
+                    if (resourceMaxAvail[r] - held[r] >= taskReqs(waiter)[i].units) {
+                        continue;
+                    }
+                    for (unsigned long holder : holders[r]) {
+                        profile.blame[BLAME_KEY(waiter, holder, r)] += dt;
+                    }
+                    profile.blockedTime[r] += dt;
+                }
+            }
+        }
+        prev = event.time;
+
+        const RESOURCE_REQ *reqs = taskReqs(event.task);
+        switch (event.type) {
+            case PROFILE_WAIT:
+                waiters.push_back(event.task);
+                for (unsigned int i = 0; i < taskInfo[event.task].reqCount; i++) {
+                    queued[reqs[i].resource]++;
+                }
+                break;
+            case PROFILE_GRANT:
+                waiters.erase(std::find(waiters.begin(), waiters.end(), event.task));
+                for (unsigned int i = 0; i < taskInfo[event.task].reqCount; i++) {
+                    queued[reqs[i].resource]--;
+                    held[reqs[i].resource] += reqs[i].units;
+                    holders[reqs[i].resource].push_back(event.task);
+                }
+                break;
+            default: // PROFILE_RELEASE
+                for (unsigned int i = 0; i < taskInfo[event.task].reqCount; i++) {
+                    std::vector<unsigned long> &resHolders = holders[reqs[i].resource];
+                    held[reqs[i].resource] -= reqs[i].units;
+                    resHolders.erase(std::find(resHolders.begin(), resHolders.end(), event.task));
+                }
+        }
+    }
+    return profile;
+}
+
+/**
+ * Returns the average fraction of a resource's units that were held
+ * @param profile the derived statistics
+ * @param r index of the resource
+ */
+static double utilization(const PROFILE &profile, unsigned long r) {
+    if (!profile.duration || !resourceMaxAvail[r]) {
+        return 0;
+    }
+    return profile.heldTime[r] / ((double) resourceMaxAvail[r] * profile.duration);
+}
+
+std::string getFormattedProfileInfo(long topN) {
+    PROFILE profile = buildProfile();
+    std::string info;
+    char buffer[1024];
+
+    // rank resources by the time tasks spent blocked on them
+    std::vector<unsigned long> resources;
+    for (unsigned long r = 0; r < resourceNames.size(); r++) {
+        resources.push_back(r);
+    }
+    std::stable_sort(resources.begin(), resources.end(), [&](unsigned long a, unsigned long b) {
+        return profile.blockedTime[a] > profile.blockedTime[b];
+    });
+    resources.resize(std::min<unsigned long>(resources.size(), topN));
+
+    sprintf(buffer, "Contention Profile (top %ld):\n\t Bottleneck resources:\n", topN);
+    info.append(buffer);
+    for (unsigned long r : resources) {
+        sprintf(buffer, "\t %s: (utilization= %5.1f%%, avgQueue= %.2f, blockedWait= %.0f msec)\n",
+                resourceNames[r].c_str(), 100 * utilization(profile, r),
+                profile.duration ? profile.queueTime[r] / profile.duration : 0,
+                profile.blockedTime[r] / 1000000.0);
+        info.append(buffer);
+    }
+
+    // rank blocking pairs by the time the waiter spent blocked by the holder
+    std::vector<std::pair<BLAME_KEY, long long>> pairs(profile.blame.begin(), profile.blame.end());
+    std::stable_sort(pairs.begin(), pairs.end(), [](const std::pair<BLAME_KEY, long long> &a,
+                                                    const std::pair<BLAME_KEY, long long> &b) {
+        return a.second > b.second;
+    });
+    pairs.resize(std::min<unsigned long>(pairs.size(), topN));
+
+    info.append("\t Blocking pairs:\n");
+    for (auto &pair : pairs) {
+        sprintf(buffer, "\t %s waited on %s holding %s: %.0f msec\n", taskName(std::get<0>(pair.first)),
+                taskName(std::get<1>(pair.first)), resourceNames[std::get<2>(pair.first)].c_str(),
+                pair.second / 1000000.0);
+        info.append(buffer);
+    }
+    return info;
+}
+
+void writeProfileCsv(const std::string &fileName) {
+    PROFILE profile = buildProfile();
+    FILE *file = fopen(fileName.c_str(), "w");
+    if (!file) {
+        printf("ERROR: cannot write profile CSV %s\n", fileName.c_str());
+        return;
+    }
+
+    const double bucketNs = PROFILE_BUCKET_MS * 1000000.0;
+    fprintf(file, "record,resource,waiter,holder,time_ms,value\n");
+    for (unsigned long r = 0; r < resourceNames.size(); r++) {
+        fprintf(file, "utilization,%s,,,,%.4f\n", resourceNames[r].c_str(), utilization(profile, r));
+        fprintf(file, "queue_depth,%s,,,,%.4f\n", resourceNames[r].c_str(),
+                profile.duration ? profile.queueTime[r] / profile.duration : 0);
+        for (unsigned long b = 0; b < profile.heldBuckets[r].size(); b++) {
+            fprintf(file, "utilization,%s,,,%ld,%.4f\n", resourceNames[r].c_str(), b * PROFILE_BUCKET_MS,
+                    resourceMaxAvail[r] ? profile.heldBuckets[r][b] / bucketNs / resourceMaxAvail[r] : 0);
+        }
+        for (unsigned long b = 0; b < profile.queueBuckets[r].size(); b++) {
+            fprintf(file, "queue_depth,%s,,,%ld,%.4f\n", resourceNames[r].c_str(), b * PROFILE_BUCKET_MS,
+                    profile.queueBuckets[r][b] / bucketNs);
+        }
+    }
+    for (auto &pair : profile.blame) {
+        fprintf(file, "blame,%s,%s,%s,,%.3f\n", resourceNames[std::get<2>(pair.first)].c_str(),
+                taskName(std::get<0>(pair.first)), taskName(std::get<1>(pair.first)), pair.second / 1000000.0);
+    }
+    fclose(file);
+}
@@ -0,0 +1,63 @@
+// The following defines a resource contention profiler for the system simulator.
+//
+// Task threads append wait, grant and release events to a buffer owned by their task (a grant made
+// by dispatchGrants() is appended by the granting thread), so recording takes no lock of its own.
+// At termination the buffers are merged by time and replayed to derive, for each resource, its
+// utilization over time, its time-weighted queue depth, and how long each task waited on it while
+// other tasks held so many units that too few were left for the waiter.
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <string>
+
+// Define the width of a utilization time bucket in the CSV output, in milliseconds.
+#define PROFILE_BUCKET_MS 100
+
+/**
+ * Enables the profiler and allocates one event buffer per task.
+ * @param nTasks the number of tasks
+ * @param iterations the expected number of iterations per task, used to size the buffers
+ */
+void profilerInit(unsigned long nTasks, unsigned long iterations);
+
+/**
+ * Returns whether the profiler is enabled.
+ */
+bool profilerEnabled();
+
+/**
+ * Records that a task started waiting for its resources. Must be called by the task's own thread.
+ * @param id index of the task
+ */
+void profileWaitBegin(unsigned long id);
+
+/**
+ * Records that a task was granted its resources. Must be called with the resource mutex held, so
+ * grants and releases are ordered consistently, by the task's own thread or by the thread granting
+ * the resources while the task waits for them.
+ * @param id index of the task
+ */
+void profileGrant(unsigned long id);
+
+/**
+ * Records that a task released its resources. Must be called by the task's own thread while it
+ * holds the resource mutex.
+ * @param id index of the task
+ */
+void profileRelease(unsigned long id);
+
+/**
+ * Replays the recorded events and formats the top bottleneck resources and blocking pairs.
+ * @param topN the number of resources and pairs to list
+ * @return the formatted report
+ */
+std::string getFormattedProfileInfo(long topN);
+
+/**
+ * Writes the per-resource utilization and queue depth time series and the blame matrix as CSV.
+ * @param fileName the file to write
+ */
+void writeProfileCsv(const std::string &fileName);
+
+#endif //PROFILER_H
@@ -0,0 +1,413 @@
+// This code implements the multi-process sharded mode declared in shard.h.
+
+#include "shard.h"
+#include "shm_state.h"
+#include "task_manager.h"
+#include "util.h"
+#include <atomic>
+#include <new>
+#include <errno.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Define an enum for the kinds of messages exchanged between shards.
+typedef enum {
+    SHARD_ACQUIRE, SHARD_RELEASE, SHARD_STOP
+} SHARD_MESSAGE_TYPE;
+
+// A message sent to a shard's inbox.
+typedef struct {
+    SHARD_MESSAGE_TYPE type; // the kind of message
+    unsigned int task; // index of the task the message is about
+} SHARD_MESSAGE;
+
+// A slot of an inbox ring. Its sequence number tells producers and the consumer whose turn it is.
+typedef struct {
+    std::atomic<unsigned long> seq; // position the slot can next be written at, or read at plus one
+    SHARD_MESSAGE message; // the message stored in the slot
+} SHARD_CELL;
+
+// The inbox of a shard: a bounded lock-free multi-producer, single-consumer ring.
+struct alignas(CACHE_LINE_SIZE) SHARD_INBOX {
+    alignas(CACHE_LINE_SIZE) std::atomic<unsigned long> head; // next position a producer claims
+    alignas(CACHE_LINE_SIZE) unsigned long tail; // next position read, owned by the shard's server thread
+    sem_t pending; // counts published messages, so the server thread can sleep while the ring is empty
+    int sockets[2]; // datagram socket pair replacing the ring with the socket transport
+    SHARD_CELL cells[SHARD_RING_SIZE]; // the ring slots
+};
+
+// The header of the segment shared by the coordinator and all shards.
+typedef struct {
+    pthread_barrier_t startBarrier; // the coordinator and all shards meet here once all task threads run
+    std::atomic<int> shardsDone; // number of shards whose tasks have all finished
+} SHARD_SEGMENT;
+
+static int SHARD = -1; // index of this shard process, or -1 in the coordinator
+static int NSHARDS = 0; // number of shard processes
+static bool USE_SOCKETS = false; // whether inboxes use the socket transport instead of the ring
+static SHARD_SEGMENT *segment; // the shared segment
+static SHARD_INBOX *inboxes; // the inbox of each shard, in the shared segment
+static TASK_STATE *results; // the final counters of each task, in the shared segment
+static pthread_t *resultThreads; // the thread ID of each task, in the shared segment
+static int *resultAvail; // the final availability of each resource type, in the shared segment
+static sem_t *grantSems; // posted by a shard when it grants a task's request, in the shared segment
+static std::vector<int> resourceShard; // the shard owning each resource type
+static std::vector<int> taskShard; // the shard running each task
+static std::vector<std::vector<int>> taskShards; // the shards owning each task's resources, ascending
+
+bool shardingEnabled() {
+    return SHARD >= 0;
+}
+
+/**
+ * Rounds a segment offset up to a whole number of cache lines
+ * @param offset the offset in bytes
+ */
+static size_t alignOffset(size_t offset) {
+    return (offset + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+}
+
+/**
+ * Waits on a semaphore in the shared segment, retrying only when interrupted by a signal
+ * @param sem the semaphore
+ */
+static void semWait(sem_t *sem) {
+    while (sem_wait(sem) < 0) {
+        if (errno != EINTR) {
+            fprintf(stderr, "shard sem_wait: %s\n", strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+/**
+ * Sends a message to a shard's inbox
+ * @param shard index of the receiving shard
+ * @param type the kind of message
+ * @param task index of the task the message is about
+ */
+static void sendMessage(int shard, SHARD_MESSAGE_TYPE type, unsigned long task) {
+    SHARD_MESSAGE message;
+    message.type = type;
+    message.task = task;
+    SHARD_INBOX *inbox = &inboxes[shard];
+
+    if (USE_SOCKETS) {
+        while (send(inbox->sockets[1], &message, sizeof(message), 0) < 0) {
+            if (errno != EINTR) {
+                fprintf(stderr, "shard send: %s\n", strerror(errno));
+                exit(EXIT_FAILURE);
+            }
+        }
+        return;
+    }
+
+    // claim a position whose slot the consumer has freed, then publish the message in it
+    unsigned long pos = inbox->head.load(std::memory_order_relaxed);
+    SHARD_CELL *cell;
+    while (true) {
+        cell = &inbox->cells[pos & (SHARD_RING_SIZE - 1)];
+        long diff = (long) cell->seq.load(std::memory_order_acquire) - (long) pos;
+        if (diff == 0) {
+            if (inbox->head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            sched_yield(); // ring full, wait for the consumer
+            pos = inbox->head.load(std::memory_order_relaxed);
+        } else {
+            pos = inbox->head.load(std::memory_order_relaxed);
+        }
+    }
+    cell->message = message;
+    cell->seq.store(pos + 1, std::memory_order_release);
+    sem_post(&inbox->pending);
+}
+
+/**
+ * Receives the next message from this shard's inbox, blocking until one arrives
+ * @return the message
+ */
+static SHARD_MESSAGE receiveMessage() {
+    SHARD_MESSAGE message;
+    SHARD_INBOX *inbox = &inboxes[SHARD];
+
+    if (USE_SOCKETS) {
+        while (recv(inbox->sockets[0], &message, sizeof(message), 0) != sizeof(message)) {
+            if (errno != EINTR) {
+                fprintf(stderr, "shard recv: %s\n", strerror(errno));
+                exit(EXIT_FAILURE);
+            }
+        }
+        return message;
+    }
+
+    semWait(&inbox->pending);
+    SHARD_CELL *cell = &inbox->cells[inbox->tail & (SHARD_RING_SIZE - 1)];
+    while (cell->seq.load(std::memory_order_acquire) != inbox->tail + 1) {
+        sched_yield(); // an earlier producer has claimed the slot but not yet published it
+    }
+    message = cell->message;
+    cell->seq.store(inbox->tail + SHARD_RING_SIZE, std::memory_order_release);
+    inbox->tail++;
+    return message;
+}
+
+/**
+ * Grants a task the units of this shard's resource types it needs, if all are available
+ * @param id index of the task
+ * @return whether the units were granted
+ */
+static bool tryGrant(unsigned long id) {
+    const RESOURCE_REQ *reqs = taskReqs(id);
+    for (unsigned int i = 0; i < taskInfo[id].reqCount; i++) {
+        if (resourceShard[reqs[i].resource] == SHARD && resourceAvail[reqs[i].resource] < reqs[i].units) {
+            return false;
+        }
+    }
+    for (unsigned int i = 0; i < taskInfo[id].reqCount; i++) {
+        if (resourceShard[reqs[i].resource] == SHARD) {
+            resourceAvail[reqs[i].resource] -= reqs[i].units;
+            shmStatePublishResource(reqs[i].resource);
+        }
+    }
+    return true;
+}
+
+/**
+ * Entry point for a shard's server thread. Owns the availability of the shard's resource types and
+ * serves messages until told to stop; requests that cannot be granted yet are retried in arrival
+ * order after every release. Grants are signalled through the task's semaphore in the shared
+ * segment, so a server never sends messages and can never block on a full inbox.
+ * @return Null pointer
+ */
+static void *serverThread(void *) {
+    std::vector<unsigned long> waiting;
+    while (true) {
+        SHARD_MESSAGE message = receiveMessage();
+        switch (message.type) {
+            case SHARD_ACQUIRE:
+                if (tryGrant(message.task)) {
+                    sem_post(&grantSems[message.task]);
+                } else {
+                    waiting.push_back(message.task);
+                }
+                break;
+            case SHARD_RELEASE: {
+                const RESOURCE_REQ *reqs = taskReqs(message.task);
+                for (unsigned int i = 0; i < taskInfo[message.task].reqCount; i++) {
+                    if (resourceShard[reqs[i].resource] == SHARD) {
+                        resourceAvail[reqs[i].resource] += reqs[i].units;
+                        shmStatePublishResource(reqs[i].resource);
+                    }
+                }
+                unsigned long kept = 0;
+                for (unsigned long id : waiting) {
+                    if (tryGrant(id)) {
+                        sem_post(&grantSems[id]);
+                    } else {
+                        waiting[kept++] = id;
+                    }
+                }
+                waiting.resize(kept);
+                break;
+            }
+            default: // SHARD_STOP
+                return nullptr;
+        }
+    }
+}
+
+void shardAcquire(unsigned long id) {
+    for (int shard : taskShards[id]) {
+        sendMessage(shard, SHARD_ACQUIRE, id);
+        semWait(&grantSems[id]);
+    }
+}
+
+void shardRelease(unsigned long id) {
+    for (int shard : taskShards[id]) {
+        sendMessage(shard, SHARD_RELEASE, id);
+    }
+}
+
+/**
+ * Assigns every resource type to a shard, and every task to the shard owning most of the units it
+ * needs
+ */
+static void partition() {
+    resourceShard.resize(resourceNames.size());
+    for (unsigned long r = 0; r < resourceNames.size(); r++) {
+        resourceShard[r] = r % NSHARDS;
+    }
+
+    taskShard.resize(taskInfo.size());
+    taskShards.resize(taskInfo.size());
+    for (unsigned long id = 0; id < taskInfo.size(); id++) {
+        std::vector<int> units(NSHARDS, 0);
+        const RESOURCE_REQ *reqs = taskReqs(id);
+        for (unsigned int i = 0; i < taskInfo[id].reqCount; i++) {
+            units[resourceShard[reqs[i].resource]] += reqs[i].units;
+        }
+        taskShard[id] = id % NSHARDS;
+        for (int shard = 0; shard < NSHARDS; shard++) {
+            if (units[shard] > units[taskShard[id]]) {
+                taskShard[id] = shard;
+            }
+            if (units[shard]) {
+                taskShards[id].push_back(shard);
+            }
+        }
+    }
+}
+
+/**
+ * Maps and initializes the segment shared by the coordinator and the shards
+ */
+static void createSegment() {
+    size_t inboxOffset = alignOffset(sizeof(SHARD_SEGMENT));
+    size_t resultOffset = alignOffset(inboxOffset + NSHARDS * sizeof(SHARD_INBOX));
+    size_t threadOffset = alignOffset(resultOffset + taskInfo.size() * sizeof(TASK_STATE));
+    size_t availOffset = alignOffset(threadOffset + taskInfo.size() * sizeof(pthread_t));
+    size_t semOffset = alignOffset(availOffset + resourceNames.size() * sizeof(int));
+    size_t size = semOffset + taskInfo.size() * sizeof(sem_t);
+
+    void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        fprintf(stderr, "shard mmap: %s\n", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    segment = (SHARD_SEGMENT *) memory;
+    inboxes = (SHARD_INBOX *) ((char *) memory + inboxOffset);
+    results = (TASK_STATE *) ((char *) memory + resultOffset);
+    resultThreads = (pthread_t *) ((char *) memory + threadOffset);
+    resultAvail = (int *) ((char *) memory + availOffset);
+    grantSems = (sem_t *) ((char *) memory + semOffset);
+
+    pthread_barrierattr_t attr;
+    pthread_barrierattr_init(&attr);
+    pthread_barrierattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    if (pthread_barrier_init(&segment->startBarrier, &attr, NSHARDS + 1)) {
+        fprintf(stderr, "shard barrier_init failed\n");
+        exit(EXIT_FAILURE);
+    }
+    pthread_barrierattr_destroy(&attr);
+    new (&segment->shardsDone) std::atomic<int>(0);
+    for (unsigned long id = 0; id < taskInfo.size(); id++) {
+        if (sem_init(&grantSems[id], 1, 0) < 0) {
+            fprintf(stderr, "shard sem_init: %s\n", strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    for (int shard = 0; shard < NSHARDS; shard++) {
+        SHARD_INBOX *inbox = &inboxes[shard];
+        new (&inbox->head) std::atomic<unsigned long>(0);
+        inbox->tail = 0;
+        for (unsigned long i = 0; i < SHARD_RING_SIZE; i++) {
+            new (&inbox->cells[i].seq) std::atomic<unsigned long>(i);
+        }
+        if (sem_init(&inbox->pending, 1, 0) < 0 ||
+            (USE_SOCKETS && socketpair(AF_UNIX, SOCK_DGRAM, 0, inbox->sockets) < 0)) {
+            fprintf(stderr, "shard inbox: %s\n", strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+/**
+ * Runs the tasks of one shard, publishes their results in the shared segment and exits
+ * @param shard index of this shard
+ */
+static void runShard(int shard) {
+    SHARD = shard;
+    std::vector<unsigned long> localTasks;
+    for (unsigned long id = 0; id < taskInfo.size(); id++) {
+        if (taskShard[id] == shard) {
+            localTasks.push_back(id);
+        }
+    }
+
+    pthread_t server = do_pthread_create_with_error_check(serverThread, nullptr);
+    createMonitorThread(0); // only sets up the status counts: run() rejects a monitor with shards
+    createTaskThreads(localTasks);
+    pthread_barrier_wait(&segment->startBarrier);
+    waitForTaskTermination();
+
+    // the last shard to finish stops every server, after all releases have been sent
+    if (segment->shardsDone.fetch_add(1) + 1 == NSHARDS) {
+        for (int s = 0; s < NSHARDS; s++) {
+            sendMessage(s, SHARD_STOP, 0);
+        }
+    }
+    do_pthread_join_with_error_check(&server);
+
+    for (unsigned long id : localTasks) {
+        results[id] = taskState[id];
+        resultThreads[id] = threads[id];
+    }
+    for (unsigned long r = 0; r < resourceNames.size(); r++) {
+        if (resourceShard[r] == shard) {
+            resultAvail[r] = resourceAvail[r];
+        }
+    }
+    fflush(stdout);
+    _exit(EXIT_SUCCESS);
+}
+
+int runSharded(const CommandLineArguments &args) {
+    NSHARDS = args.shards;
+    USE_SOCKETS = args.transport == SOCKET_TRANSPORT;
+    partition();
+    createSegment();
+
+    printf("Creating %d shard processes (transport= %s)...\n", NSHARDS, args.transport.c_str());
+    fflush(stdout); // do not let the shards inherit buffered output
+    long long startupStart = monotonic_ns();
+    std::vector<pid_t> pids(NSHARDS);
+    for (int shard = 0; shard < NSHARDS; shard++) {
+        pids[shard] = fork();
+        if (pids[shard] < 0) {
+            fprintf(stderr, "fork: %s\n", strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+        if (pids[shard] == 0) {
+            runShard(shard);
+        }
+    }
+    pthread_barrier_wait(&segment->startBarrier);
+    setSimulationStart((monotonic_ns() - startupStart) / 1000000.0);
+
+    printf("Waiting for shards to finish...\n");
+    fflush(stdout);
+    int status = EXIT_SUCCESS;
+    for (int shard = 0; shard < NSHARDS; shard++) {
+        int shardStatus;
+        if (waitpid(pids[shard], &shardStatus, 0) < 0 || !WIFEXITED(shardStatus) || WEXITSTATUS(shardStatus)) {
+            printf("ERROR: shard %d failed\n", shard);
+            status = EXIT_FAILURE;
+        }
+    }
+
+    // merge the shards' results into the tables the termination report reads
+    threads.resize(taskInfo.size());
+    for (unsigned long id = 0; id < taskInfo.size(); id++) {
+        taskState[id] = results[id];
+        threads[id] = resultThreads[id];
+    }
+    for (unsigned long r = 0; r < resourceNames.size(); r++) {
+        resourceAvail[r] = resultAvail[r];
+    }
+
+    printf("Shards Finished...\n");
+    printTerminationInfo(args);
+    printf("Shards= %d (transport= %s)\n", NSHARDS, args.transport.c_str());
+    return status;
+}
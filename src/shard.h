@@ -0,0 +1,51 @@
+// The following defines the multi-process sharded mode of the system simulator.
+//
+// The coordinator process partitions the resource types across a number of shard processes
+// (resource type r belongs to shard r % nShards) and places every task on the shard owning most of
+// the units it needs. Each shard runs the threads of its own tasks plus a server thread that owns
+// the availability counters of the shard's resource types and serves ACQUIRE and RELEASE requests
+// from all shards through the shard's inbox. A task acquires its resources shard by shard in
+// ascending shard order, all-or-nothing within each shard, which keeps cross-shard acquisition free
+// of deadlock. The coordinator merges the shards' results into a single termination report.
+
+#ifndef SHARD_H
+#define SHARD_H
+
+#include "parsers.h"
+
+// Define the number of messages each shard inbox ring can hold (a power of two).
+#define SHARD_RING_SIZE 16384
+
+// Define the maximum number of shard processes.
+#define MAX_SHARDS 64
+
+// Define the names of the inbox transports.
+#define SHM_TRANSPORT "shm"
+#define SOCKET_TRANSPORT "socket"
+
+/**
+ * Returns whether this process is a shard of a sharded simulation.
+ */
+bool shardingEnabled();
+
+/**
+ * Acquires all resources a task needs from the shards owning them. Blocks until all are granted.
+ * @param id index of the task
+ */
+void shardAcquire(unsigned long id);
+
+/**
+ * Returns all resources a task holds to the shards owning them.
+ * @param id index of the task
+ */
+void shardRelease(unsigned long id);
+
+/**
+ * Runs the simulation of the parsed input file across args.shards processes and prints the merged
+ * termination report.
+ * @param args the command line arguments for the simulation
+ * @return EXIT_SUCCESS if all shards complete successfully
+ */
+int runSharded(const CommandLineArguments &args);
+
+#endif //SHARD_H
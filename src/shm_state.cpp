@@ -0,0 +1,108 @@
+// This code implements the live shared-memory state segment declared in shm_state.h.
+
+#include "shm_state.h"
+#include "task_manager.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+static std::string segmentName; // the POSIX shared memory object name
+static SIMSTATE_HEADER *header = nullptr; // the mapped segment, or null when not publishing
+static SIMSTATE_RESOURCE *resourceRecords; // the resource records in the segment
+static SIMSTATE_TASK *taskRecords; // the task records in the segment
+
+/**
+ * Opens a record for writing by making its sequence number odd
+ * @param seq the record's sequence number
+ * @return the sequence number to store once the record is written
+ */
+static uint32_t beginWrite(std::atomic<uint32_t> &seq) {
+    uint32_t value = seq.load(std::memory_order_relaxed);
+    seq.store(value + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return value + 2;
+}
+
+void shmStateOpen(const std::string &name) {
+    size_t resourceOffset = sizeof(SIMSTATE_RESOURCE) * ((sizeof(SIMSTATE_HEADER) + sizeof(SIMSTATE_RESOURCE) - 1) /
+                                                         sizeof(SIMSTATE_RESOURCE));
+    size_t taskOffset = resourceOffset + resourceNames.size() * sizeof(SIMSTATE_RESOURCE);
+    size_t size = taskOffset + taskInfo.size() * sizeof(SIMSTATE_TASK);
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (fd < 0 || ftruncate(fd, size) < 0) {
+        printf("ERROR: cannot create shared memory state %s: %s\n", name.c_str(), strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        printf("ERROR: cannot map shared memory state %s: %s\n", name.c_str(), strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    segmentName = name;
+    resourceRecords = (SIMSTATE_RESOURCE *) ((char *) memory + resourceOffset);
+    taskRecords = (SIMSTATE_TASK *) ((char *) memory + taskOffset);
+
+    // ftruncate zero-filled the segment, so every record starts out with an even sequence number
+    for (unsigned long r = 0; r < resourceNames.size(); r++) {
+        strncpy(resourceRecords[r].name, resourceNames[r].c_str(), SIMSTATE_NAME_LENGTH - 1);
+        resourceRecords[r].maxAvail.store(resourceMaxAvail[r], std::memory_order_relaxed);
+        resourceRecords[r].avail.store(resourceAvail[r], std::memory_order_relaxed);
+    }
+    for (unsigned long id = 0; id < taskInfo.size(); id++) {
+        strncpy(taskRecords[id].name, taskName(id), SIMSTATE_NAME_LENGTH - 1);
+        taskRecords[id].status.store(taskState[id].status, std::memory_order_relaxed);
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    header = (SIMSTATE_HEADER *) memory;
+    header->nResources = resourceNames.size();
+    header->nTasks = taskInfo.size();
+    header->resourceOffset = resourceOffset;
+    header->taskOffset = taskOffset;
+    header->startTime = now.tv_sec * 1000000000LL + now.tv_nsec;
+    header->pid = getpid();
+    header->version = SIMSTATE_VERSION;
+    header->running.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = SIMSTATE_MAGIC; // readers may use the segment once the magic number is set
+}
+
+void shmStatePublishTask(unsigned long id) {
+    if (!header) {
+        return;
+    }
+    SIMSTATE_TASK &record = taskRecords[id];
+    const TASK_STATE &state = taskState[id];
+    uint32_t seq = beginWrite(record.seq);
+    record.status.store(state.status, std::memory_order_relaxed);
+    record.timesExecuted.store(state.timesExecuted, std::memory_order_relaxed);
+    record.totalWaitTime.store(state.totalWaitTime, std::memory_order_relaxed);
+    record.totalBusyTime.store(state.totalBusyTime, std::memory_order_relaxed);
+    record.seq.store(seq, std::memory_order_release);
+}
+
+void shmStatePublishResource(unsigned long r) {
+    if (!header) {
+        return;
+    }
+    SIMSTATE_RESOURCE &record = resourceRecords[r];
+    uint32_t seq = beginWrite(record.seq);
+    record.avail.store(resourceAvail[r], std::memory_order_relaxed);
+    record.seq.store(seq, std::memory_order_release);
+}
+
+void shmStateClose() {
+    if (!header) {
+        return;
+    }
+    header->running.store(0, std::memory_order_release);
+    shm_unlink(segmentName.c_str());
+}
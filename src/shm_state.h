@@ -0,0 +1,81 @@
+// The following defines the live state segment the simulator can publish in POSIX shared memory.
+//
+// The segment starts with a SIMSTATE_HEADER, followed by one SIMSTATE_RESOURCE per resource type
+// and one SIMSTATE_TASK per task at the offsets the header gives. Every record is guarded by its
+// own seqlock: the single writer of a record makes `seq` odd, updates the fields and makes `seq`
+// even again, and readers retry until they see the same even `seq` before and after copying the
+// fields. Writers never wait on readers, so external tools such as simtop can sample the segment
+// at any rate without task threads taking a mutex. Each record fills exactly one cache line.
+//
+// The layout is versioned: readers must check `magic` and `version` before using any other field.
+
+#ifndef SHM_STATE_H
+#define SHM_STATE_H
+
+#include <atomic>
+#include <stdint.h>
+#include <string>
+
+// Define the identification of the segment layout.
+#define SIMSTATE_MAGIC 0x53494d53 // "SIMS"
+#define SIMSTATE_VERSION 1
+
+// Define the maximum length of a name stored in the segment, including the terminating null.
+#define SIMSTATE_NAME_LENGTH 40
+
+// The header of the segment, written once before any record is published.
+typedef struct {
+    uint32_t magic; // SIMSTATE_MAGIC
+    uint32_t version; // SIMSTATE_VERSION
+    uint32_t nResources; // the number of SIMSTATE_RESOURCE records
+    uint32_t nTasks; // the number of SIMSTATE_TASK records
+    uint64_t resourceOffset; // offset of the first SIMSTATE_RESOURCE record from the segment start
+    uint64_t taskOffset; // offset of the first SIMSTATE_TASK record from the segment start
+    int64_t startTime; // CLOCK_REALTIME time the simulation was started at, in nanoseconds
+    int32_t pid; // process ID of the simulator
+    std::atomic<uint32_t> running; // 1 while the simulation runs, 0 once it finished
+} SIMSTATE_HEADER;
+
+// The published state of a resource type.
+struct alignas(64) SIMSTATE_RESOURCE {
+    std::atomic<uint32_t> seq; // the record's seqlock sequence number
+    std::atomic<int32_t> maxAvail; // the number of units of the resource type in the system
+    std::atomic<int32_t> avail; // the number of currently available units
+    char name[SIMSTATE_NAME_LENGTH]; // the resource type's name, written before the first publication
+};
+
+// The published state of a task.
+struct alignas(64) SIMSTATE_TASK {
+    std::atomic<uint32_t> seq; // the record's seqlock sequence number
+    std::atomic<int32_t> status; // the task's STATUS
+    std::atomic<int32_t> timesExecuted; // the number of completed iterations
+    std::atomic<int32_t> totalWaitTime; // the total time the task has waited, in milliseconds
+    std::atomic<int32_t> totalBusyTime; // the total time the task has been busy, in milliseconds
+    char name[SIMSTATE_NAME_LENGTH]; // the task's name, written before the first publication
+};
+
+/**
+ * Creates the named segment and publishes the initial state of all resources and tasks.
+ * @param name the POSIX shared memory object name, e.g. "/a4w23tasks"
+ */
+void shmStateOpen(const std::string &name);
+
+/**
+ * Publishes the current status and counters of a task. Must be called by the task's own thread.
+ * @param id index of the task
+ */
+void shmStatePublishTask(unsigned long id);
+
+/**
+ * Publishes the current availability of a resource type. Must be called by the current owner of
+ * the resource tables (the holder of the resource mutex, or a shard's server thread).
+ * @param r index of the resource type
+ */
+void shmStatePublishResource(unsigned long r);
+
+/**
+ * Marks the simulation as finished and removes the segment's name.
+ */
+void shmStateClose();
+
+#endif //SHM_STATE_H
@@ -0,0 +1,92 @@
+// This code implements the fixed-duration run mode declared in steady_state.h.
+
+#include "steady_state.h"
+#include "task_manager.h"
+#include <algorithm>
+#include <stdio.h>
+
+// The statistics of a task over the measurement window, written only by the task's own thread.
+struct alignas(CACHE_LINE_SIZE) WINDOW_STATS {
+    unsigned long iterations; // the number of iterations completed inside the window
+    long long totalWait; // the total wait time of these iterations
+    std::vector<long long> waits; // the wait time of each of these iterations
+};
+
+static bool enabled = false; // whether the run is limited by a duration
+static long long windowStart; // the end of the warm-up period
+static long long windowEnd; // the deadline
+static std::vector<WINDOW_STATS> windowStats; // the statistics of each task
+
+void steadyStateInit(unsigned long nTasks, long durationMs, long warmupMs) {
+    windowStart = warmupMs * 1000000LL;
+    windowEnd = durationMs * 1000000LL;
+    windowStats.resize(nTasks);
+    enabled = true;
+}
+
+bool steadyStateEnabled() {
+    return enabled;
+}
+
+bool steadyStateRunning(long long now) {
+    return now < windowEnd;
+}
+
+void steadyStateRecord(unsigned long id, long long wait, long long end) {
+    if (end < windowStart || end >= windowEnd) {
+        return;
+    }
+    WINDOW_STATS &stats = windowStats[id];
+    stats.iterations++;
+    stats.totalWait += wait;
+    stats.waits.push_back(wait);
+}
+
+/**
+ * Returns the value at a percentile of sorted values
+ * @param sorted the values, in ascending order
+ * @param percentile the percentile, from 0 to 100
+ */
+static long long percentile(const std::vector<long long> &sorted, double percentile) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    return sorted[std::min(sorted.size() - 1, (size_t) (percentile / 100 * sorted.size()))];
+}
+
+std::string getFormattedSteadyStateInfo() {
+    if (!enabled) {
+        return "";
+    }
+    double seconds = (windowEnd - windowStart) / 1e9;
+    std::string info;
+    char buffer[1024];
+    sprintf(buffer, "Steady state: window= [%.0f, %.0f) msec\n", windowStart / 1e6, windowEnd / 1e6);
+    info.append(buffer);
+
+    std::vector<long long> allWaits;
+    unsigned long iterations = 0;
+    for (unsigned long id = 0; id < windowStats.size(); id++) {
+        WINDOW_STATS &stats = windowStats[id];
+        std::sort(stats.waits.begin(), stats.waits.end());
+        sprintf(buffer, "\t %s: %.2f iter/sec, wait mean= %.3f msec, p99= %.3f msec\n", taskName(id),
+                stats.iterations / seconds, stats.iterations ? stats.totalWait / 1e6 / stats.iterations : 0.0,
+                percentile(stats.waits, 99) / 1e6);
+        info.append(buffer);
+        iterations += stats.iterations;
+        allWaits.insert(allWaits.end(), stats.waits.begin(), stats.waits.end());
+    }
+
+    std::sort(allWaits.begin(), allWaits.end());
+    long long totalWait = 0;
+    for (long long wait : allWaits) {
+        totalWait += wait;
+    }
+    sprintf(buffer, "\t overall: %.2f iter/sec (%lu iterations), wait mean= %.3f msec, p50= %.3f msec, "
+                    "p90= %.3f msec, p99= %.3f msec, max= %.3f msec\n",
+            iterations / seconds, iterations, iterations ? totalWait / 1e6 / iterations : 0.0,
+            percentile(allWaits, 50) / 1e6, percentile(allWaits, 90) / 1e6, percentile(allWaits, 99) / 1e6,
+            allWaits.empty() ? 0.0 : allWaits.back() / 1e6);
+    info.append(buffer);
+    return info;
+}
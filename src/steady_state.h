@@ -0,0 +1,49 @@
+// The following defines the fixed-duration run mode and its steady-state statistics.
+//
+// In this mode every task keeps starting iterations until the deadline, instead of stopping after
+// NITER iterations, so all tasks contend for the whole run. Statistics are only taken over the
+// measurement window from the end of the warm-up period to the deadline: an iteration counts if it
+// completes inside the window, so neither start-up effects nor the iterations cut short by the
+// deadline skew the throughput and wait times. Times are measured in nanoseconds from the release
+// of the task threads.
+
+#ifndef STEADY_STATE_H
+#define STEADY_STATE_H
+
+#include <string>
+
+/**
+ * Enables the fixed-duration mode.
+ * @param nTasks the number of tasks
+ * @param durationMs the time after which tasks start no more iterations, in milliseconds
+ * @param warmupMs the time excluded from the statistics at the start of the run, in milliseconds
+ */
+void steadyStateInit(unsigned long nTasks, long durationMs, long warmupMs);
+
+/**
+ * Returns whether the run is limited by a duration instead of a number of iterations.
+ */
+bool steadyStateEnabled();
+
+/**
+ * Returns whether tasks should start another iteration.
+ * @param now the current time
+ */
+bool steadyStateRunning(long long now);
+
+/**
+ * Records a completed iteration if it falls inside the measurement window. Must be called by the
+ * task's own thread.
+ * @param id index of the task
+ * @param wait the time the iteration waited for its resources
+ * @param end the time the iteration completed
+ */
+void steadyStateRecord(unsigned long id, long long wait, long long end);
+
+/**
+ * Formats the throughput and wait time statistics of the measurement window.
+ * @return the summary, or an empty string if the mode is disabled
+ */
+std::string getFormattedSteadyStateInfo();
+
+#endif //STEADY_STATE_H
@@ -1,4 +1,9 @@
-// The following defines a struct for representing a task in a system.
+// The following defines the structs for representing a task in a system.
+//
+// Task data is kept as a struct of arrays: the immutable metadata of every task (TASK_INFO, plus
+// the name and requirement arenas) is written once while parsing the input file and only read
+// afterwards, while the counters each task thread writes on every iteration live in TASK_STATE,
+// which occupies a cache line of its own so neighbouring task threads never false-share.
 
 #ifndef TASK_H
 #define TASK_H
@@ -7,10 +12,12 @@
 #include <string>
 #include <vector>
 
-// Define constants for the maximum number of tasks and resource types.
-#define NTASKS 25
+// Define a constant for the maximum number of resource types.
 #define NRES_TYPES 10
 
+// Size of a cache line on the targeted hardware.
+#define CACHE_LINE_SIZE 64
+
 // Use the following namespace.
 using std::string;
 
@@ -19,17 +26,34 @@ typedef enum {
 WAIT, RUN, IDLE
 } STATUS;
 
+// The number of task statuses.
+#define NSTATUS 3
+
+// A single resource requirement of a task.
 typedef struct {
-char name[100]; // The name of the task.
+int resource; // Index of the resource type in the resource tables.
+int units; // The number of units of the resource type needed.
+} RESOURCE_REQ;
+
+// Immutable metadata of a task.
+typedef struct {
+unsigned int nameOffset; // Offset of the task's name in the task name arena.
 int busyTime; // The amount of time the task is busy.
 int idleTime; // The amount of time the task is idle.
+unsigned int reqOffset; // Offset of the task's first requirement in the requirement arena.
+unsigned int reqCount; // The number of resource types required by the task.
+unsigned int afterOffset; // Offset of the task's first predecessor in the predecessor arena.
+unsigned int afterCount; // The number of tasks whose iteration k must complete before the task's iteration k.
+} TASK_INFO;
+
+// Hot, mutable counters of a task, padded to a full cache line.
+struct alignas(CACHE_LINE_SIZE) TASK_STATE {
 long totalBusyTime; // The total amount of time the task has been busy.
 long totalIdleTime; // The total amount of time the task has been idle.
 long totalWaitTime; // The total amount of time the task has waited.
-vector <string> reqResources; // A vector of strings representing the resources required by the task.
-bool assigned; // A flag indicating if the task has been assigned resources.
 int timesExecuted; // The number of times the task has been executed.
 STATUS status; // The status of the task.
-} TASK;
+bool dirty; // A flag indicating if the task is queued in the monitor's list of changed tasks.
+};
 
-#endif
\ No newline at end of file
+#endif
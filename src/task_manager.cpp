@@ -1,27 +1,63 @@
 // This code is for a task manager application that manages tasks with different resources.
 
+#include "atomic_alloc.h"
+#include "busy.h"
+#include "dag.h"
+#include "event_log.h"
+#include "grant_log.h"
 #include "parsers.h"
+#include "profiler.h"
+#include "shard.h"
+#include "shm_state.h"
+#include "steady_state.h"
 #include "task_manager.h"
 #include "util.h"
+#include <algorithm>
+#include <pthread.h>
 #include <string.h>
 #include <sys/times.h>
 
 // Global variables
-std::map<std::string, int> resourceMap; // map of resources and their current availability
-std::vector<TASK> taskList; // holds information about all tasks
-pthread_t threads[NTASKS]; // holds thread IDs of worker threads
+std::map<std::string, int> resourceIndex; // map of resource names to their index in the resource tables
+std::vector<std::string> resourceNames; // name of each resource type
+std::vector<int> resourceAvail; // current availability of each resource type
+std::vector<int> resourceMaxAvail; // total units of each resource type
+std::vector<TASK_INFO> taskInfo; // read-only metadata of all tasks
+std::vector<TASK_STATE> taskState; // hot per-task counters, one cache line each
+std::string taskNameArena; // task names referenced by TASK_INFO::nameOffset
+std::vector<RESOURCE_REQ> taskReqArena; // task requirements referenced by TASK_INFO::reqOffset
+std::vector<unsigned int> taskAfterArena; // task predecessors referenced by TASK_INFO::afterOffset
+std::vector<pthread_t> threads; // holds thread IDs of worker threads, by task index
+std::vector<unsigned long> threadTasks; // the task bound to each worker thread
 
 // Global variables for time tracking
 uint ITERATIONS = 0; // number of iterations to run for each task
-clock_t START = 0; // time when program started
+clock_t START = 0; // time when the task threads were released
 clock_t END; // time when program ended
 long _CLK_TCK = 0; // clock ticks per second
+double STARTUP_TIME = 0; // time in milliseconds taken to create and release all task threads
+long long START_NS = 0; // CLOCK_MONOTONIC time in nanoseconds when the task threads were released
+
+// Barrier all task threads and the main thread meet at, so that all tasks start simultaneously
+pthread_barrier_t startBarrier;
 
 // Mutexes for thread synchronization
-pthread_mutex_t threadMutex; // mutex to lock worker threads
-pthread_mutex_t resourceMapMutex; // mutex to lock resourceMap
+pthread_mutex_t resourceMapMutex; // mutex to lock resourceAvail
+pthread_cond_t grantCond; // signalled on every grant and release while a grant order is replayed
 pthread_mutex_t monitorMutex; // mutex to lock monitor thread
 
+// Critical path ordered grants, protected by resourceMapMutex
+std::vector<unsigned long> grantQueue; // waiting tasks in descending priority order, while tasks have dependencies
+std::vector<char> granted; // whether a queued task was granted its resources, by task index
+
+// Monitor state, protected by monitorMutex
+pthread_cond_t monitorCond; // signalled when the monitor thread should stop
+pthread_t monitorThreadID; // thread ID of the monitor thread
+bool monitorRunning = false; // whether the monitor thread should keep running
+long SNAPSHOT_EVERY = 0; // print a full snapshot every this many monitor ticks (0 = never)
+std::vector<unsigned long> dirtyTasks; // tasks whose status changed since the last monitor tick
+long statusCount[NSTATUS]; // number of tasks in each status
+
 /**
     Returns the time in milliseconds that have passed since reading the input file.
     */
@@ -40,19 +76,19 @@ void printMonitor() {
     std::string runTasks;
     std::string idleTasks;
 
-    // Iterate through taskList to add names of tasks to the appropriate string
-    for (auto &task : taskList) {
-            switch (task.status) {
+    // Iterate through the tasks to add their names to the appropriate string
+    for (unsigned long id = 0; id < taskState.size(); id++) {
+            switch (taskState[id].status) {
                 case WAIT:
-                waitTasks.append(task.name);
+                waitTasks.append(taskName(id));
                 waitTasks.append(" ");
                 break;
             case RUN:
-                runTasks.append(task.name);
+                runTasks.append(taskName(id));
                 runTasks.append(" ");
                 break;
             default:
-                idleTasks.append(task.name);
+                idleTasks.append(taskName(id));
                 idleTasks.append(" ");
         }
     }
@@ -62,43 +98,95 @@ void printMonitor() {
         runTasks.c_str(), idleTasks.c_str());
     }
 
+/**
+    Prints to the screen the number of tasks in each status and the tasks whose
+    status changed since the previous monitor tick.
+    @param changes The tasks that changed status, with their new status
+    @param counts The number of tasks in each status
+    */
+void printMonitorDelta(const std::vector<std::pair<unsigned long, STATUS>> &changes, const long *counts) {
+    std::string waitTasks;
+    std::string runTasks;
+    std::string idleTasks;
+
+    // Only the changed tasks are listed, so the cost of a tick is proportional to the number of transitions
+    for (auto &change : changes) {
+        std::string &tasks = change.second == WAIT ? waitTasks : change.second == RUN ? runTasks : idleTasks;
+        tasks.append(taskName(change.first));
+        tasks.append(" ");
+    }
+
+    printf("Monitor: (WAIT= %ld, RUN= %ld, IDLE= %ld, changed= %zu)\n"
+           "\t [WAIT] %s\n\t [RUN] %s\n\t [IDLE] %s\n\n",
+           counts[WAIT], counts[RUN], counts[IDLE], changes.size(),
+           waitTasks.c_str(), runTasks.c_str(), idleTasks.c_str());
+    }
+
 /**
 
     Entry point for a monitor thread.
-    Prints to the screen the STATUS of tasks
-    every interval milliseconds.
+    Every interval milliseconds, prints to the screen the tasks whose STATUS
+    changed since the previous tick, and every SNAPSHOT_EVERY ticks the STATUS
+    of all tasks. Returns once stopMonitorThread() is called.
     @param arg Pointer to the interval for the monitor thread to run
     @return Null pointer
     */
 void *monitorThread(void *arg) {
     auto monitorTime = (long) arg;
-    while (true) {
-        delay(monitorTime); // wait for specified time
+    std::vector<STATUS> reported(taskState.size(), IDLE); // status of each task as last printed
+    std::vector<unsigned long> pending;
+    std::vector<std::pair<unsigned long, STATUS>> changes;
+    long counts[NSTATUS];
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+
+    for (long tick = 1;; tick++) {
+        deadline.tv_sec += (deadline.tv_nsec + monitorTime % 1000 * 1000000) / 1000000000 + monitorTime / 1000;
+        deadline.tv_nsec = (deadline.tv_nsec + monitorTime % 1000 * 1000000) % 1000000000;
+
         mutex_lock(&monitorMutex); // acquire lock on monitorMutex
-        printMonitor(); // print task status
+        while (monitorRunning && cond_timedwait(&monitorCond, &monitorMutex, &deadline)) {
+        }
+        if (!monitorRunning) {
+            mutex_unlock(&monitorMutex);
+            break;
+        }
+
+        // take the tasks that changed status since the last tick
+        pending.swap(dirtyTasks);
+        changes.clear();
+        for (unsigned long id : pending) {
+            taskState[id].dirty = false;
+            if (taskState[id].status != reported[id]) {
+                reported[id] = taskState[id].status;
+                changes.emplace_back(id, reported[id]);
+            }
+        }
+        pending.clear();
+        std::copy(statusCount, statusCount + NSTATUS, counts);
+
+        bool snapshot = SNAPSHOT_EVERY && tick % SNAPSHOT_EVERY == 0;
+        if (snapshot) {
+            printMonitor(); // print status of all tasks
+        }
         mutex_unlock(&monitorMutex); // release lock on monitorMutex
+
+        if (!snapshot) {
+            printMonitorDelta(changes, counts);
+        }
         }
     return nullptr;
     }
 
 /**
     Returns whether all resources required by a task are available
-    @param task Pointer to the task to check
+    @param id Index of the task to check
     @return True if all required resources are available, false otherwise
     */
-bool checkResourcesAvailable(TASK *task) {
-    for (auto &resourceString : task->reqResources) {
-
-    // Parse resource name and required number of units from the resource string
-    char *saveptr;
-    char resource[MAX_RESOURCE_LENGTH];
-
-    strcpy(resource, resourceString.c_str());
-
-    char *resName = strtok_r(resource, ":", &saveptr);
-    int resNumber = atoi(strtok_r(nullptr, ":", &saveptr));
-
-     if (resourceMap[resName] < resNumber) {
+bool checkResourcesAvailable(unsigned long id) {
+    const RESOURCE_REQ *reqs = taskReqs(id);
+    for (unsigned int i = 0; i < taskInfo[id].reqCount; i++) {
+     if (resourceAvail[reqs[i].resource] < reqs[i].units) {
      return false;
     }
  }
@@ -108,26 +196,64 @@ return true;
 
 // This function switches a task's status with the restriction that tasks cannot switch if the monitor is printing.
 // It locks and unlocks the monitor mutex to ensure that task statuses will not change while the monitor thread is printing.
-void switchStatus(TASK *task, STATUS status) {
+void switchStatus(unsigned long id, STATUS status) {
 
     mutex_lock(&monitorMutex); //Lock the monitor mutex to prevent the monitor thread from printing while the task status is being updated.
-    task->status = status; // Set the task's status to the new status.
+    statusCount[taskState[id].status]--; // Move the task between the per-status counts.
+    statusCount[status]++;
+    taskState[id].status = status; // Set the task's status to the new status.
+    if (!taskState[id].dirty) { // Queue the task for the next monitor tick.
+        taskState[id].dirty = true;
+        dirtyTasks.push_back(id);
+    }
+    shmStatePublishTask(id); // Publish the new status and counters to the shared memory state, if enabled.
     mutex_unlock(&monitorMutex);  //Unlock the monitor mutex.
 }
 
+void dispatchGrants();
+
 /**
  * Locks the resource map, checks if resources are available for a resource,
- * and unlocks the map if they are not.
+ * and unlocks the map if they are not. While a grant order is replayed, the
+ * task also waits for its turn in the replayed log. With the lock-free
+ * allocator, the resources are granted here without taking the map mutex.
+ * With task dependencies, the task queues for dispatchGrants() instead.
  */
-void waitForResources(TASK *task) { // todo - fix does not work correctly
-    switchStatus(task, WAIT);
+void waitForResources(unsigned long id) { // todo - fix does not work correctly
+    switchStatus(id, WAIT);
+    if (shardingEnabled()) {
+        shardAcquire(id); // the shards owning the resources grant them in one step
+        return;
+    }
+    if (dagEnabled()) {
+        mutex_lock(&resourceMapMutex);
+        auto pos = std::upper_bound(grantQueue.begin(), grantQueue.end(), id, [](unsigned long a, unsigned long b) {
+            return dagPriority(a) > dagPriority(b);
+        });
+        grantQueue.insert(pos, id); // behind the queued tasks of equal or higher priority
+        dispatchGrants();
+        while (!granted[id]) {
+            cond_wait(dagGrantCond(id), &resourceMapMutex);
+        }
+        granted[id] = false;
+        return;
+    }
+    if (atomicAllocEnabled()) {
+        while (!atomicAllocTryAcquire(id)) { // all or nothing, in a single CAS
+            delay(20);
+        }
+        return;
+    }
     bool resAvailable = false;
+    mutex_lock(&resourceMapMutex);
     while (!resAvailable) {
-        mutex_lock(&resourceMapMutex);
-        resAvailable = checkResourcesAvailable(task);
-        if (!resAvailable) {
+        resAvailable = grantLogIsTurn(id) && checkResourcesAvailable(id);
+        if (!resAvailable && grantLogReplaying()) {
+            cond_wait(&grantCond, &resourceMapMutex); // woken by every grant and release, so turns are not missed
+        } else if (!resAvailable) {
             mutex_unlock(&resourceMapMutex);
             delay(20);
+            mutex_lock(&resourceMapMutex);
         }
     }
 }
@@ -147,93 +273,176 @@ int sub(int a, int b) {
     in the resource map
     It requires wrapper functions to lock the map mutex.
     */
-void adjustResources(TASK *task, int (*operation)(int, int)) {
-    for (auto &resourceString : task->reqResources) { // Iterate through the task's required resources.
-        char *saveptr;
-        char resource[MAX_RESOURCE_LENGTH];
+void adjustResources(unsigned long id, int (*operation)(int, int)) {
+    const RESOURCE_REQ *reqs = taskReqs(id);
+    for (unsigned int i = 0; i < taskInfo[id].reqCount; i++) { // Iterate through the task's required resources.
+        int currentValue = resourceAvail[reqs[i].resource]; // Get the current value of the resource.
 
-        strcpy(resource, resourceString.c_str()); // Copy the resource string to a local variable.
-        char *resName = strtok_r(resource, ":", &saveptr); // Parse the resource name from the string.
-        int resNumber = atoi(strtok_r(nullptr, ":", &saveptr)); // Parse the resource number from the string.
-        int currentValue = resourceMap[resName]; // Get the current value of the resource from the resource map.
+        resourceAvail[reqs[i].resource] = operation(currentValue, reqs[i].units); // Apply the arithmetic operation to the resource value.
+        shmStatePublishResource(reqs[i].resource); // Publish the new value to the shared memory state, if enabled.
 
-        resourceMap[resName] = operation(currentValue, resNumber); // Apply the arithmetic operation to the resource value in the map.
+    }
+}
 
+/**
+ * Grants resources to the queued tasks in descending critical path priority,
+ * skipping tasks whose resources are not all available.
+ * It requires wrapper functions to lock the map mutex.
+ */
+void dispatchGrants() {
+    for (auto itr = grantQueue.begin(); itr != grantQueue.end();) {
+        if (checkResourcesAvailable(*itr)) {
+            adjustResources(*itr, sub); // Take the resources now, so lower priority tasks cannot
+            profileGrant(*itr); // Stamp the grant now, not when the woken task gets to run
+            granted[*itr] = true;
+            cond_broadcast(dagGrantCond(*itr));
+            itr = grantQueue.erase(itr);
+        } else {
+            itr++;
+        }
     }
 }
 
 /**
  * Removes the resources used by a task from the resource map
- * @param task The task whose resources should be procured
+ * @param id Index of the task whose resources should be procured
  */
-void procureResources(TASK *task) {
-    adjustResources(task, sub); // Adjust resources used by the task
+void procureResources(unsigned long id) {
+    if (shardingEnabled()) {
+        return; // already granted by the owning shards
+    }
+    if (atomicAllocEnabled()) {
+        return; // already granted by the lock-free allocator
+    }
+    if (dagEnabled()) {
+        mutex_unlock(&resourceMapMutex);
+        return; // already granted and profiled by dispatchGrants()
+    }
+    adjustResources(id, sub); // Adjust resources used by the task
+    profileGrant(id); // Record the grant for the contention profiler
+    grantLogGrant(id); // Record or replay the grant in the grant log
+    if (grantLogReplaying()) {
+        cond_broadcast(&grantCond); // Let the task next in the replayed grant order check its turn
+    }
     mutex_unlock(&resourceMapMutex); // Unlock the mutex for the resource map
 }
 
 /**
  * Adds the resources used by a task to the resource map
- * @param task The task whose resources should be released
+ * @param id Index of the task whose resources should be released
  */
-void releaseResources(TASK *task) {
+void releaseResources(unsigned long id) {
+    if (shardingEnabled()) {
+        shardRelease(id); // return the resources to the owning shards
+        return;
+    }
+    if (atomicAllocEnabled()) {
+        atomicAllocRelease(id); // return the resources with a single atomic add
+        return;
+    }
     mutex_lock(&resourceMapMutex); // Lock the mutex for the resource map
-    adjustResources(task, add); // Adjust resources used by the task
+    adjustResources(id, add); // Adjust resources used by the task
+    profileRelease(id); // Record the release for the contention profiler
+    grantLogRelease(id); // Record or check the release in the grant log
+    if (dagEnabled()) {
+        dispatchGrants(); // Grant the released resources to the waiting tasks with the longest critical paths
+    }
+    if (grantLogReplaying()) {
+        cond_broadcast(&grantCond); // Let waiting tasks recheck the released resources
+    }
     mutex_unlock(&resourceMapMutex); // Unlock the mutex for the resource map
 }
 
 /**
  * Runs a single iteration of a task
- * @param task The task to run
+ * @param id Index of the task to run
  */
-void runTaskIteration(TASK *task) {
-    procureResources(task); // Procure the resources needed by the task (note: map mutex gets unlocked here)
-    delay(task->busyTime); // Wait for the task's busy time
-    task->totalBusyTime += task->busyTime; // Add the busy time to the task's total busy time
-    releaseResources(task); // Release the resources used by the task
+void runTaskIteration(unsigned long id) {
+    procureResources(id); // Procure the resources needed by the task (note: map mutex gets unlocked here)
+    if (busyEnabled()) {
+        busyRun(id, taskInfo[id].busyTime); // Burn CPU in the calibrated kernel for the task's busy time
+    } else {
+        delay(taskInfo[id].busyTime); // Wait for the task's busy time
+    }
+    taskState[id].totalBusyTime += taskInfo[id].busyTime; // Add the busy time to the task's total busy time
+    releaseResources(id); // Release the resources used by the task
 }
 
 /**
  * Runs a single idle period for a task
- * @param task The task to run the idle period for
+ * @param id Index of the task to run the idle period for
  */
-void doTaskIdle(TASK *task) {
-    delay(task->idleTime); // Wait for the task's idle time
-    task->totalIdleTime += task->idleTime; // Add the idle time to the task's total idle time
+void doTaskIdle(unsigned long id) {
+    delay(taskInfo[id].idleTime); // Wait for the task's idle time
+    taskState[id].totalIdleTime += taskInfo[id].idleTime; // Add the idle time to the task's total idle time
 }
 
 /**
- * Runs a task ITERATIONS times
- * @param task The task to run
+ * Runs a task ITERATIONS times, or until the deadline in the fixed-duration mode
+ * @param id Index of the task to run
  */
-void runTask(TASK *task) {
+void runTask(unsigned long id) {
+    TASK_STATE *task = &taskState[id];
     clock_t iterStart, iterWait;
     struct tms tmsIterStart, tmsIterWait;
     uint iterCount = 0;
-
-    while (iterCount != ITERATIONS) {
-        switchStatus(task, WAIT); // Switch the task status to waiting
+    long long waitBeginNs = monotonic_ns() - START_NS, grantNs, runEndNs, idleEndNs;
+
+    while (steadyStateEnabled() ? steadyStateRunning(waitBeginNs) : iterCount != ITERATIONS) {
+        if (dagEnabled()) {
+            if (!dagWaitForPredecessors(id, iterCount + 1)) {
+                break; // A predecessor stopped before completing this iteration
+            }
+            waitBeginNs = monotonic_ns() - START_NS; // Time blocked on predecessors is not resource wait
+        }
+        switchStatus(id, WAIT); // Switch the task status to waiting
         iterStart = times(&tmsIterStart); // Record the start time of the iteration
-        waitForResources(task); // Wait for resources to become available
+        profileWaitBegin(id); // Record the start of the wait for the contention profiler
+        waitForResources(id); // Wait for resources to become available
         iterWait = times(&tmsIterWait); // Record the time the task waited for resources
         task->totalWaitTime += (iterWait - iterStart) * 1000 / _CLK_TCK; // Add the wait time to the task's total wait time
+        grantNs = monotonic_ns() - START_NS;
 
-        switchStatus(task, RUN); // Switch the task status to running
-        runTaskIteration(task); // Run a single iteration of the task
+        switchStatus(id, RUN); // Switch the task status to running
+        runTaskIteration(id); // Run a single iteration of the task
+        runEndNs = monotonic_ns() - START_NS;
 
-        switchStatus(task, IDLE); // Switch the task status to idle
-        doTaskIdle(task); // Run a single idle period for the task
+        switchStatus(id, IDLE); // Switch the task status to idle
+        doTaskIdle(id); // Run a single idle period for the task
+        idleEndNs = monotonic_ns() - START_NS;
 
         task->timesExecuted += 1; // Increment the number of times the task has been executed
         iterCount++; // Increment the iteration count
-        printf("task: %s (tid= %lu, iter= %d, time= %.0f msec) \n", task->name, pthread_self(),
-               iterCount, getTime()); // Print out information about the task execution
+        if (eventLogEnabled()) { // Queue the iteration for the event log writer instead of printing it
+            eventLogRecord(id, iterCount, waitBeginNs, grantNs, runEndNs, idleEndNs);
+        } else {
+            printf("task: %s (tid= %lu, iter= %d, time= %.0f msec) \n", taskName(id), pthread_self(),
+                   iterCount, getTime()); // Print out information about the task execution
+        }
+        if (steadyStateEnabled()) { // Count the iteration if it completed inside the measurement window
+            steadyStateRecord(id, grantNs - waitBeginNs, idleEndNs);
+        }
+        if (dagEnabled()) { // Let the successors waiting for this iteration start it
+            dagComplete(id, grantNs, idleEndNs);
+        }
+        waitBeginNs = idleEndNs; // Iterations are back to back, so the next wait starts here
     }
+    if (dagEnabled()) {
+        dagFinish(id);
+    }
+    if (grantLogReplaying()) { // Skip the task's remaining grants, so it cannot block the tasks after it
+        mutex_lock(&resourceMapMutex);
+        grantLogFinish(id);
+        cond_broadcast(&grantCond);
+        mutex_unlock(&resourceMapMutex);
+    }
+    shmStatePublishTask(id); // Publish the final counters to the shared memory state, if enabled
 }
 
 /**
  * Prints out final statistics for the system
  */
-void printTerminationInfo() {
+void printTerminationInfo(const CommandLineArguments &args) {
     std::string systemResources;
     std::string systemTasks;
     systemResources = getFormattedResourceInfo(); // Get formatted resource information
@@ -242,29 +451,41 @@ void printTerminationInfo() {
            "\n"
            "\n"
            "System Tasks: \n%s"
-           "Running time= %.0f msec\n", systemResources.c_str(), systemTasks.c_str(), getTime());
+           "Startup time= %.3f msec (%zu threads)\n"
+           "Running time= %.0f msec\n", systemResources.c_str(), systemTasks.c_str(), STARTUP_TIME,
+           taskInfo.size(), getTime());
+
+    printf("%s", getFormattedDagInfo().c_str());
+    printf("%s", getFormattedSteadyStateInfo().c_str());
+    printf("%s", getFormattedBusyInfo(getTime()).c_str());
+    printf("%s", getFormattedAtomicAllocInfo().c_str());
+    printf("%s", getFormattedGrantLogInfo().c_str());
+    printf("%s", getFormattedEventLogInfo().c_str());
+
+    if (profilerEnabled()) {
+        printf("\n%s", getFormattedProfileInfo(args.profileTop).c_str());
+        if (!args.profileCsv.empty()) {
+            writeProfileCsv(args.profileCsv);
+        }
+    }
 }
 /**
 
     Entry point for a TASK thread.
-    Assigns the first unassigned thread to the current thread, then unlocks the
-    thread mutex.
-    @param arg the index of the current thread in the threads array
+    Threads are created as a binary tree: thread `n` first creates threads
+    2*n+1 and 2*n+2, so thread creation proceeds in parallel. It then waits at
+    the start barrier and runs the task bound to it in threadTasks.
+    @param arg the index of the current thread in threadTasks
     */
 void *task_start_routine(void *arg) {
-    // Assign the first unassigned thread to the current thread
-    threads[(long) arg] = pthread_self();
-    for (auto &task : taskList) {
-        if (task.assigned) {
-            continue;
-                            }
-            task.assigned = true;
-            // Unlock the thread mutex
-            mutex_unlock(&threadMutex);
-            // Run the task assigned to this thread
-            runTask(&task);
-            break;
-        }
+    auto n = (unsigned long) arg;
+    for (unsigned long child = 2 * n + 1; child <= 2 * n + 2 && child < threadTasks.size(); child++) {
+        threads[threadTasks[child]] = do_pthread_create_with_error_check(task_start_routine, (void *) child);
+    }
+
+    // Wait until every task thread exists, then run the task bound to this thread
+    barrier_wait(&startBarrier);
+    runTask(threadTasks[n]);
     pthread_exit(nullptr);
     }
 
@@ -274,18 +495,61 @@ void *task_start_routine(void *arg) {
     @param time the monitoring interval in milliseconds
     */
     void createMonitorThread(long time) {
-    do_pthread_create_with_error_check(&monitorThread, (void *) time);
+    statusCount[IDLE] = taskInfo.size(); // all tasks start out idle
+    dirtyTasks.reserve(taskInfo.size());
+    if (time <= 0) {
+    return; // a monitorTime of 0 disables the monitor
+    }
+    monitorRunning = true;
+    monitorThreadID = do_pthread_create_with_error_check(&monitorThread, (void *) time);
+    }
+
+/**
+
+    Stops the monitor thread and waits for it to exit.
+    */
+    void stopMonitorThread() {
+    mutex_lock(&monitorMutex);
+    bool wasRunning = monitorRunning;
+    monitorRunning = false;
+    cond_broadcast(&monitorCond);
+    mutex_unlock(&monitorMutex);
+    if (wasRunning) {
+    do_pthread_join_with_error_check(&monitorThreadID);
+    }
     }
 
 /**
 
-    Creates all task threads and assigns tasks to them.
+    Creates a thread for each of the given tasks, each bound to its task by
+    index, and releases them at once through the start barrier. Records the time
+    this took in STARTUP_TIME and starts the simulation clock.
+    @param tasks the indices of the tasks to run
     */
-    void createTaskThreads() {
-    for (unsigned long i = 0; i < taskList.size(); i++) {
-    mutex_lock(&threadMutex);
-    do_pthread_create_with_error_check(task_start_routine, (void *) i);
+    void createTaskThreads(const std::vector<unsigned long> &tasks) {
+    long long startupStart = monotonic_ns();
+
+    threadTasks = tasks;
+    threads.resize(taskInfo.size());
+    barrier_init(&startBarrier, threadTasks.size() + 1);
+    if (!threadTasks.empty()) {
+    threads[threadTasks[0]] = do_pthread_create_with_error_check(task_start_routine, (void *) 0); // root of the creation tree
     }
+    START_NS = monotonic_ns(); // published to the task threads by the barrier
+    barrier_wait(&startBarrier);
+
+    setSimulationStart((monotonic_ns() - startupStart) / 1000000.0);
+    }
+
+/**
+
+    Starts the simulation clock that getTime() measures from.
+    @param startupTime the time in milliseconds it took to start the task threads
+    */
+    void setSimulationStart(double startupTime) {
+    tms tmsstart;
+    START = times(&tmsstart);
+    STARTUP_TIME = startupTime;
     }
 
 /**
@@ -293,8 +557,8 @@ void *task_start_routine(void *arg) {
     Waits for all task threads to finish executing.
     */
     void waitForTaskTermination() {
-    for (unsigned int i = 0; i < taskList.size(); i++) {
-    do_pthread_join_with_error_check(&threads[i]);
+    for (unsigned long id : threadTasks) {
+    do_pthread_join_with_error_check(&threads[id]);
     }
     }
 
@@ -306,8 +570,8 @@ void *task_start_routine(void *arg) {
     @return EXIT_SUCCESS if the simulation completes successfully
     */
     int run(CommandLineArguments args) {
-    tms tmsstart;
     ITERATIONS = args.iterations;
+    SNAPSHOT_EVERY = args.snapshotEvery;
 
     if ((_CLK_TCK = sysconf(_SC_CLK_TCK)) < 0) {
     printf("ERROR: getting sysconfig clock tick\n");
@@ -316,24 +580,136 @@ void *task_start_routine(void *arg) {
 
     printf("Reading File...\n");
     readInputFile(args.inputFileName);
+    dagInit();
 
-    START = times(&tmsstart);
+    if (args.shards && dagEnabled()) {
+    printf("ERROR: task dependencies are not supported with shards\n");
+    return EINVAL;
+    }
+
+    if (dagEnabled() && (!args.recordFile.empty() || !args.replayFile.empty())) {
+    printf("ERROR: recording or replaying grants is not supported with task dependencies\n");
+    return EINVAL;
+    }
+    granted.resize(taskInfo.size());
+
+    if (args.shards && args.monitorTime > 0) {
+    printf("ERROR: the monitor is not supported with shards (use a monitorTime of 0)\n");
+    return EINVAL;
+    }
+
+    if (args.shards && (args.profileTop || !args.profileCsv.empty())) {
+    printf("ERROR: the contention profiler is not supported with shards\n");
+    return EINVAL;
+    }
+
+    if (args.shards && (!args.recordFile.empty() || !args.replayFile.empty())) {
+    printf("ERROR: recording or replaying grants is not supported with shards\n");
+    return EINVAL;
+    }
+
+    // the lock-free allocator bypasses the resource mutex every other mode observes grants under
+    bool lockedModes = args.shards || args.profileTop || !args.profileCsv.empty() || !args.recordFile.empty() ||
+                       !args.replayFile.empty() || !args.shmState.empty() || dagEnabled();
+    if (args.allocator == ATOMIC_ALLOCATOR && lockedModes) {
+    printf("ERROR: the atomic allocator is not supported with shards, the profiler, grant logs, shared memory state "
+           "or task dependencies\n");
+    return EINVAL;
+    }
+
+    if (args.allocator != MUTEX_ALLOCATOR && !lockedModes && !atomicAllocInit() &&
+        args.allocator == ATOMIC_ALLOCATOR) {
+    printf("Resources do not fit the atomic allocator, using the mutex allocator...\n");
+    }
+
+    if (args.shards && !args.eventsFile.empty()) {
+    printf("ERROR: the event log is not supported with shards\n");
+    return EINVAL;
+    }
+
+    if (args.shards && args.duration) {
+    printf("ERROR: the fixed-duration mode is not supported with shards\n");
+    return EINVAL;
+    }
+
+    if (args.duration && !args.replayFile.empty()) {
+    printf("ERROR: replaying grants is not supported with the fixed-duration mode\n");
+    return EINVAL;
+    }
+
+    if (args.warmup && !args.duration) {
+    printf("ERROR: --warmup requires --duration\n");
+    return EINVAL;
+    }
+
+    if (args.warmup && args.warmup >= args.duration) {
+    printf("ERROR: warmup must be shorter than duration\n");
+    return EINVAL;
+    }
+
+    if (args.duration) {
+    steadyStateInit(taskInfo.size(), args.duration, args.warmup);
+    }
+
+    if (args.shards && args.busyMode != SLEEP_BUSY) {
+    printf("ERROR: CPU busy modes are not supported with shards\n");
+    return EINVAL;
+    }
+
+    if (args.busyMode != SLEEP_BUSY) {
+    busyInit(args.busyMode, taskInfo.size());
+    }
+
+    if (args.profileTop || !args.profileCsv.empty()) {
+    profilerInit(taskInfo.size(), ITERATIONS);
+    }
+
+    if (!args.recordFile.empty()) {
+    grantLogRecordOpen(args.recordFile, ITERATIONS);
+    } else if (!args.replayFile.empty()) {
+    grantLogReplayOpen(args.replayFile, ITERATIONS);
+    }
+
+    if (!args.eventsFile.empty()) {
+    eventLogOpen(args.eventsFile);
+    }
+
+    if (!args.shmState.empty()) {
+    printf("Publishing state to shared memory %s...\n", args.shmState.c_str());
+    shmStateOpen(args.shmState);
+    }
 
     printf("Mutexes Initializing...\n");
-    mutex_init(&threadMutex);
     mutex_init(&resourceMapMutex);
+    cond_init(&grantCond);
     mutex_init(&monitorMutex);
+    cond_init(&monitorCond);
+
+    if (args.shards) {
+    int status = runSharded(args);
+    shmStateClose();
+    return status;
+    }
 
     printf("Creating monitor thread...\n");
     createMonitorThread(args.monitorTime);
     printf("Creating task threads...\n");
-    createTaskThreads();
-    delay(400); // delay long enough for threads array to be initialized
+    std::vector<unsigned long> tasks(taskInfo.size());
+    for (unsigned long id = 0; id < tasks.size(); id++) {
+    tasks[id] = id;
+    }
+    createTaskThreads(tasks);
 
     printf("Waiting for tasks to finish...\n");
     waitForTaskTermination();
+    stopMonitorThread();
+
+    atomicAllocClose();
+    shmStateClose();
+    grantLogClose();
+    eventLogClose();
 
     printf("Tasks Finished...\n");
-    printTerminationInfo();
+    printTerminationInfo(args);
     return EXIT_SUCCESS;
     }
\ No newline at end of file
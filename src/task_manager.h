@@ -8,13 +8,52 @@
 #include "task.h"
 #include <map>
 #include <string>
+#include <pthread.h>
 
 // Declare global variables.
-extern std::map<std::string, int> resourceMap; // A map of resources and their availability.
-extern std::vector <TASK> taskList; // A vector of tasks.
-extern pthread_t threads[NTASKS]; // An array of threads used for executing tasks.
+extern std::map<std::string, int> resourceIndex; // A map of resource names to their index in the resource tables.
+extern std::vector<std::string> resourceNames; // The name of each resource type, by index.
+extern std::vector<int> resourceAvail; // The number of currently available units of each resource type.
+extern std::vector<int> resourceMaxAvail; // The number of units of each resource type in the system.
+extern std::vector<TASK_INFO> taskInfo; // Read-only metadata of each task.
+extern std::vector<TASK_STATE> taskState; // Mutable counters of each task, one cache line per task.
+extern std::string taskNameArena; // Null-terminated task names, referenced by TASK_INFO::nameOffset.
+extern std::vector<RESOURCE_REQ> taskReqArena; // Task requirements, referenced by TASK_INFO::reqOffset.
+extern std::vector<unsigned int> taskAfterArena; // Task predecessor indices, referenced by TASK_INFO::afterOffset.
+extern std::vector<pthread_t> threads; // Thread IDs used for executing tasks, by task index.
+
+/**
+ * Returns the name of a task.
+ * @param id index of the task
+ */
+inline const char *taskName(unsigned long id) {
+    return taskNameArena.c_str() + taskInfo[id].nameOffset;
+}
+
+/**
+ * Returns a pointer to the first resource requirement of a task.
+ * @param id index of the task
+ */
+inline const RESOURCE_REQ *taskReqs(unsigned long id) {
+    return taskReqArena.data() + taskInfo[id].reqOffset;
+}
+
+/**
+ * Returns a pointer to the index of the first predecessor of a task.
+ * @param id index of the task
+ */
+inline const unsigned int *taskAfter(unsigned long id) {
+    return taskAfterArena.data() + taskInfo[id].afterOffset;
+}
+
+// Declare functions shared with the sharded mode.
+void createMonitorThread(long time);
+void createTaskThreads(const std::vector<unsigned long> &tasks);
+void setSimulationStart(double startupTime);
+void waitForTaskTermination();
+void printTerminationInfo(const CommandLineArguments &args);
 
 // Declare function for running the system simulation.
 int run(CommandLineArguments args);
 
-#endif //TASKMANAGER_H
\ No newline at end of file
+#endif //TASKMANAGER_H
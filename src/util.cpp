@@ -22,6 +22,16 @@ void delay(int delay) {
         printf("warning: delay: %s\n", strerror(errno));
 }
 
+/**
+ * Returns the current CLOCK_MONOTONIC time
+ * @return The time in nanoseconds
+ */
+long long monotonic_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
 /**
  * Initializes a mutex
  * @param mutex A pointer to the mutex variable
@@ -58,6 +68,87 @@ void mutex_unlock(pthread_mutex_t *mutex) {
     }
 }
 
+/**
+ * Initializes a condition variable
+ * @param cond A pointer to the condition variable
+ */
+void cond_init(pthread_cond_t *cond) {
+    int rval = pthread_cond_init(cond, NULL);
+    if (rval) {
+        fprintf(stderr, "cond_init: %s\n", strerror(rval));
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * Wakes all threads waiting on a condition variable
+ * @param cond A pointer to the condition variable
+ */
+void cond_broadcast(pthread_cond_t *cond) {
+    int rval = pthread_cond_broadcast(cond);
+    if (rval) {
+        fprintf(stderr, "cond_broadcast: %s\n", strerror(rval));
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * Waits on a condition variable until it is signalled
+ * @param cond A pointer to the condition variable
+ * @param mutex A pointer to the locked mutex guarding the condition
+ */
+void cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex) {
+    int rval = pthread_cond_wait(cond, mutex);
+    if (rval) {
+        fprintf(stderr, "cond_wait: %s\n", strerror(rval));
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * Waits on a condition variable until it is signalled or the deadline passes
+ * @param cond A pointer to the condition variable
+ * @param mutex A pointer to the locked mutex guarding the condition
+ * @param deadline The absolute CLOCK_REALTIME time to stop waiting at
+ * @return false if the deadline passed, true otherwise
+ */
+bool cond_timedwait(pthread_cond_t *cond, pthread_mutex_t *mutex, const struct timespec *deadline) {
+    int rval = pthread_cond_timedwait(cond, mutex, deadline);
+    if (rval == ETIMEDOUT) {
+        return false;
+    }
+    if (rval) {
+        fprintf(stderr, "cond_timedwait: %s\n", strerror(rval));
+        exit(EXIT_FAILURE);
+    }
+    return true;
+}
+
+/**
+ * Initializes a barrier
+ * @param barrier A pointer to the barrier variable
+ * @param count The number of threads that must wait at the barrier before it opens
+ */
+void barrier_init(pthread_barrier_t *barrier, unsigned int count) {
+    int rval = pthread_barrier_init(barrier, NULL, count);
+    if (rval) {
+        fprintf(stderr, "barrier_init: %s\n", strerror(rval));
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * Waits at a barrier until all of its threads have reached it
+ * @param barrier A pointer to the barrier variable
+ */
+void barrier_wait(pthread_barrier_t *barrier) {
+    int rval = pthread_barrier_wait(barrier);
+    if (rval && rval != PTHREAD_BARRIER_SERIAL_THREAD) {
+        fprintf(stderr, "barrier_wait: %s\n", strerror(rval));
+        exit(EXIT_FAILURE);
+    }
+}
+
 /**
  * Waits for the specified thread to terminate
  * @param pthread A pointer to the thread to wait for
@@ -74,8 +165,9 @@ void do_pthread_join_with_error_check(pthread_t* pthread) {
  * Creates a new thread
  * @param start_function A pointer to the function that the new thread will execute
  * @param arg A pointer to the argument that will be passed to the new thread's start function
+ * @return The ID of the new thread
  */
-void do_pthread_create_with_error_check(void *(*start_function)(void *), void *arg) {
+pthread_t do_pthread_create_with_error_check(void *(*start_function)(void *), void *arg) {
     pthread_t threadID;
     int rval = pthread_create(&threadID, NULL, start_function, arg);
 
@@ -84,4 +176,5 @@ void do_pthread_create_with_error_check(void *(*start_function)(void *), void *a
         fprintf(stderr, "pthread_create: %s\n", strerror(rval));
         exit(EXIT_FAILURE);
     }
+    return threadID;
 }
@@ -2,6 +2,8 @@
 #define UTIL_H
 
 #include <zconf.h> // for delay()
+#include <pthread.h>
+#include <time.h>
 
 /**
  * Delays the current thread by `delay` milliseconds.
@@ -9,6 +11,11 @@
  */
 void delay(int delay);
 
+/**
+ * Returns the current CLOCK_MONOTONIC time in nanoseconds.
+ */
+long long monotonic_ns();
+
 /**
  * Initializes a mutex.
  * @param mutex pointer to a pthread_mutex_t struct
@@ -27,6 +34,47 @@ void mutex_lock(pthread_mutex_t* mutex);
  */
 void mutex_unlock(pthread_mutex_t* mutex);
 
+/**
+ * Initializes a condition variable.
+ * @param cond pointer to a pthread_cond_t struct
+ */
+void cond_init(pthread_cond_t* cond);
+
+/**
+ * Wakes all threads waiting on a condition variable.
+ * @param cond pointer to a pthread_cond_t struct
+ */
+void cond_broadcast(pthread_cond_t* cond);
+
+/**
+ * Waits on a condition variable until it is signalled.
+ * @param cond pointer to a pthread_cond_t struct
+ * @param mutex pointer to the locked pthread_mutex_t guarding the condition
+ */
+void cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex);
+
+/**
+ * Waits on a condition variable until it is signalled or `deadline` passes.
+ * @param cond pointer to a pthread_cond_t struct
+ * @param mutex pointer to the locked pthread_mutex_t guarding the condition
+ * @param deadline absolute CLOCK_REALTIME time to stop waiting at
+ * @return false if the deadline passed, true otherwise
+ */
+bool cond_timedwait(pthread_cond_t* cond, pthread_mutex_t* mutex, const struct timespec* deadline);
+
+/**
+ * Initializes a barrier.
+ * @param barrier pointer to a pthread_barrier_t struct
+ * @param count number of threads that must wait at the barrier before it opens
+ */
+void barrier_init(pthread_barrier_t* barrier, unsigned int count);
+
+/**
+ * Waits at a barrier until `count` threads have reached it.
+ * @param barrier pointer to a pthread_barrier_t struct
+ */
+void barrier_wait(pthread_barrier_t* barrier);
+
 /**
  * Joins a thread and checks for errors.
  * @param pthread pointer to the thread ID
@@ -37,8 +85,9 @@ void do_pthread_join_with_error_check(pthread_t* pthread);
  * Creates a thread and checks for errors.
  * @param start_function pointer to the function to be executed by the new thread
  * @param arg pointer to the argument to pass to the start function
+ * @return the ID of the new thread
  */
-void do_pthread_create_with_error_check(void *(*start_function)(void *), void *arg);
+pthread_t do_pthread_create_with_error_check(void *(*start_function)(void *), void *arg);
 
 #endif //UTIL_H
 
@@ -0,0 +1,59 @@
+// The following defines the LEB128-style variable-length integer encoding shared by the binary log
+// formats: seven bits per byte, least significant group first, with the high bit set on every byte
+// but the last. Signed values are zigzag-mapped first, so small magnitudes of either sign stay short.
+
+#ifndef VARINT_H
+#define VARINT_H
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Appends a varint to a byte buffer
+ * @param buffer the buffer to append to
+ * @param value the value to encode
+ */
+inline void putVarint(std::vector<uint8_t> &buffer, uint64_t value) {
+    while (value >= 0x80) {
+        buffer.push_back((uint8_t) (value | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back((uint8_t) value);
+}
+
+/**
+ * Decodes a varint from a byte buffer
+ * @param buffer the buffer to read from
+ * @param pos the position to read at, advanced past the varint
+ * @param value the decoded value
+ * @return false if the buffer ended inside the varint
+ */
+inline bool getVarint(const std::vector<uint8_t> &buffer, unsigned long &pos, uint64_t &value) {
+    value = 0;
+    for (int shift = 0; pos < buffer.size() && shift < 64; shift += 7) {
+        uint8_t byte = buffer[pos++];
+        value |= (uint64_t) (byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Maps a signed value to an unsigned one with small magnitudes first: 0, -1, 1, -2, 2, ...
+ * @param value the signed value
+ */
+inline uint64_t zigzag(int64_t value) {
+    return ((uint64_t) value << 1) ^ (uint64_t) (value >> 63);
+}
+
+/**
+ * Reverses zigzag().
+ * @param value the zigzag-mapped value
+ */
+inline int64_t unzigzag(uint64_t value) {
+    return (int64_t) (value >> 1) ^ -(int64_t) (value & 1);
+}
+
+#endif //VARINT_H
@@ -0,0 +1,182 @@
+// evlog2csv: converts an event log a4w23tasks writes with --events to CSV.
+//
+// Prints one row per task iteration with the columns
+//     task,name,iteration,wait_ns,run_ns,idle_ns,grant_ns
+// where grant_ns is the time the task was granted its resources, measured from the release of the
+// task threads. The file format is described in src/event_log.h.
+//
+// Usage: ./evlog2csv file [columns]
+//    file     the file passed to --events
+//    columns  comma-separated subset of the columns above to print (default all)
+
+#include <algorithm>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "event_log.h"
+#include "varint.h"
+
+// Define the names of the CSV columns, in the order they are printed by default.
+static const char *CSV_COLUMNS[] = {"task", "name", "iteration", "wait_ns", "run_ns", "idle_ns", "grant_ns"};
+#define CSV_COLUMN_COUNT 7
+
+// A column of a block being decoded.
+typedef struct {
+    unsigned long pos; // the position of the next token
+    uint64_t zeros; // the number of zeros left in the current run
+} COLUMN_READER;
+
+/**
+ * Prints an error about the input file and exits
+ * @param fileName the input file
+ * @param message what is wrong with it
+ */
+static void fail(const char *fileName, const char *message) {
+    fprintf(stderr, "evlog2csv: %s: %s\n", fileName, message);
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Decodes the next value of a column, expanding runs of zeros
+ * @param buffer the file contents
+ * @param column the column to read from
+ * @param value the decoded value
+ * @return false if the column ended inside a token
+ */
+static bool getValue(const std::vector<uint8_t> &buffer, COLUMN_READER &column, uint64_t &value) {
+    if (column.zeros) {
+        column.zeros--;
+        value = 0;
+        return true;
+    }
+    uint64_t token;
+    if (!getVarint(buffer, column.pos, token)) {
+        return false;
+    }
+    if (token & 1) {
+        column.zeros = token >> 1; // this value is the first zero of the run
+        value = 0;
+    } else {
+        value = (token >> 1) + 1;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2 || argc > 3) {
+        printf("Usage: %s file [columns]\n", argv[0]);
+        return EINVAL;
+    }
+
+    // select the columns to print
+    std::vector<int> selected;
+    std::string list = argc > 2 ? argv[2] : "task,name,iteration,wait_ns,run_ns,idle_ns,grant_ns";
+    for (size_t start = 0; start <= list.size();) {
+        size_t end = std::min(list.find(',', start), list.size());
+        std::string column = list.substr(start, end - start);
+        int c = 0;
+        while (c < CSV_COLUMN_COUNT && column != CSV_COLUMNS[c]) {
+            c++;
+        }
+        if (c == CSV_COLUMN_COUNT) {
+            fprintf(stderr, "evlog2csv: unknown column %s\n", column.c_str());
+            return EINVAL;
+        }
+        selected.push_back(c);
+        start = end + 1;
+    }
+
+    FILE *file = fopen(argv[1], "rb");
+    if (!file) {
+        fail(argv[1], strerror(errno));
+    }
+    std::vector<uint8_t> buffer;
+    uint8_t chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        buffer.insert(buffer.end(), chunk, chunk + n);
+    }
+    fclose(file);
+
+    unsigned long pos = strlen(EVENT_LOG_MAGIC);
+    uint64_t version, resolution, nTasks, length;
+    if (buffer.size() < pos || memcmp(buffer.data(), EVENT_LOG_MAGIC, pos) != 0 || !getVarint(buffer, pos, version)) {
+        fail(argv[1], "not an event log");
+    }
+    if (version != EVENT_LOG_VERSION) {
+        fail(argv[1], "unsupported event log version");
+    }
+    std::vector<std::string> names;
+    if (!getVarint(buffer, pos, resolution) || !getVarint(buffer, pos, nTasks)) {
+        fail(argv[1], "truncated header");
+    }
+    for (uint64_t id = 0; id < nTasks; id++) {
+        if (!getVarint(buffer, pos, length) || pos + length > buffer.size()) {
+            fail(argv[1], "truncated header");
+        }
+        names.emplace_back((const char *) buffer.data() + pos, length);
+        pos += length;
+    }
+
+    for (size_t i = 0; i < selected.size(); i++) {
+        printf("%s%s", i ? "," : "", CSV_COLUMNS[selected[i]]);
+    }
+    printf("\n");
+
+    while (pos < buffer.size()) {
+        // locate the columns of the block
+        uint64_t nRecords, size;
+        COLUMN_READER columns[EVENT_LOG_COLUMNS];
+        if (!getVarint(buffer, pos, nRecords)) {
+            fail(argv[1], "truncated block");
+        }
+        for (int c = 0; c < EVENT_LOG_COLUMNS; c++) {
+            if (!getVarint(buffer, pos, size) || pos + size > buffer.size()) {
+                fail(argv[1], "truncated block");
+            }
+            columns[c] = COLUMN_READER{pos, 0};
+            pos += size;
+        }
+
+        // decode the rows, reversing the delta encoding of every column
+        int64_t task = 0, iteration = 0, run = 0, idle = 0, grant = 0;
+        uint64_t value[EVENT_LOG_COLUMNS];
+        for (uint64_t row = 0; row < nRecords; row++) {
+            for (int c = 0; c < EVENT_LOG_COLUMNS; c++) {
+                if (!getValue(buffer, columns[c], value[c])) {
+                    fail(argv[1], "truncated column");
+                }
+            }
+            bool sameTask = row && value[EVENT_TASK] == 0;
+            int64_t wait = value[EVENT_WAIT];
+            task += value[EVENT_TASK];
+            iteration += unzigzag(value[EVENT_ITERATION]) + 1;
+            grant += (sameTask ? run + idle + wait : 0) + unzigzag(value[EVENT_GRANT]);
+            run += unzigzag(value[EVENT_RUN]);
+            idle += unzigzag(value[EVENT_IDLE]);
+            if ((uint64_t) task >= nTasks) {
+                fail(argv[1], "task index out of range");
+            }
+
+            for (size_t i = 0; i < selected.size(); i++) {
+                if (i) {
+                    putchar(',');
+                }
+                switch (selected[i]) {
+                    case 0: printf("%lld", (long long) task); break;
+                    case 1: fputs(names[task].c_str(), stdout); break;
+                    case 2: printf("%lld", (long long) iteration); break;
+                    case 3: printf("%lld", (long long) (wait * resolution)); break;
+                    case 4: printf("%lld", (long long) (run * resolution)); break;
+                    case 5: printf("%lld", (long long) (idle * resolution)); break;
+                    default: printf("%lld", (long long) (grant * resolution)); break;
+                }
+            }
+            putchar('\n');
+        }
+    }
+    return EXIT_SUCCESS;
+}
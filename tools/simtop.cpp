@@ -0,0 +1,169 @@
+// simtop: samples the live state segment a4w23tasks publishes with --shm-state and prints the
+// availability of every resource type and the status and counters of the busiest tasks.
+//
+// Records are read under their seqlocks, so sampling never blocks or slows down the simulator.
+//
+// Usage: ./simtop name [intervalMsec] [frames]
+//    name          the shared memory name passed to --shm-state
+//    intervalMsec  time between frames (default 500)
+//    frames        number of frames to print before exiting (default 0, until the simulation ends)
+
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+#include "shm_state.h"
+#include "task.h"
+
+// Define the maximum number of task rows printed per frame.
+#define MAX_TASK_ROWS 20
+
+// A consistent copy of a task record.
+typedef struct {
+    int32_t status;
+    int32_t timesExecuted;
+    int32_t totalWaitTime;
+    int32_t totalBusyTime;
+    const char *name;
+} TASK_SAMPLE;
+
+static long retries = 0; // number of times a record changed while it was being copied
+
+/**
+ * Copies a resource record, retrying until no write overlapped the copy
+ * @param record the record to read
+ * @return the number of available units
+ */
+static int32_t readResource(const SIMSTATE_RESOURCE &record) {
+    while (true) {
+        uint32_t seq = record.seq.load(std::memory_order_acquire);
+        int32_t avail = record.avail.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (!(seq & 1) && seq == record.seq.load(std::memory_order_relaxed)) {
+            return avail;
+        }
+        retries++;
+    }
+}
+
+/**
+ * Copies a task record, retrying until no write overlapped the copy
+ * @param record the record to read
+ * @return the copy
+ */
+static TASK_SAMPLE readTask(const SIMSTATE_TASK &record) {
+    TASK_SAMPLE sample;
+    sample.name = record.name;
+    while (true) {
+        uint32_t seq = record.seq.load(std::memory_order_acquire);
+        sample.status = record.status.load(std::memory_order_relaxed);
+        sample.timesExecuted = record.timesExecuted.load(std::memory_order_relaxed);
+        sample.totalWaitTime = record.totalWaitTime.load(std::memory_order_relaxed);
+        sample.totalBusyTime = record.totalBusyTime.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (!(seq & 1) && seq == record.seq.load(std::memory_order_relaxed)) {
+            return sample;
+        }
+        retries++;
+    }
+}
+
+/**
+ * Maps the segment read-only, waiting up to a second for the simulator to finish creating it
+ * @param name the shared memory name
+ * @return the segment header
+ */
+static const SIMSTATE_HEADER *openSegment(const char *name) {
+    for (int attempt = 0; attempt < 100; attempt++, usleep(10000)) {
+        int fd = shm_open(name, O_RDONLY, 0);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) < 0 || st.st_size < (off_t) sizeof(SIMSTATE_HEADER)) {
+            if (fd >= 0) close(fd);
+            continue;
+        }
+        void *memory = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        const SIMSTATE_HEADER *header = (const SIMSTATE_HEADER *) memory;
+        if (memory == MAP_FAILED) {
+            break;
+        }
+        if (header->magic != SIMSTATE_MAGIC) {
+            munmap(memory, st.st_size);
+            continue;
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header->version != SIMSTATE_VERSION) {
+            fprintf(stderr, "simtop: %s has layout version %u, expected %u\n", name, header->version,
+                    SIMSTATE_VERSION);
+            exit(EXIT_FAILURE);
+        }
+        return header;
+    }
+    fprintf(stderr, "simtop: cannot open %s: %s\n", name, strerror(errno));
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Prints one frame of the segment's state
+ * @param name the shared memory name
+ * @param header the segment header
+ * @return whether the simulation is still running
+ */
+static bool printFrame(const char *name, const SIMSTATE_HEADER *header) {
+    static const char *statusNames[NSTATUS] = {"WAIT", "RUN", "IDLE"};
+    bool running = header->running.load(std::memory_order_acquire);
+    const SIMSTATE_RESOURCE *resources = (const SIMSTATE_RESOURCE *) ((const char *) header + header->resourceOffset);
+    const SIMSTATE_TASK *tasks = (const SIMSTATE_TASK *) ((const char *) header + header->taskOffset);
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    printf("simtop: %s (pid= %d, %s, %.1f sec)\nResources:\n", name, header->pid, running ? "running" : "finished",
+           (now.tv_sec * 1000000000LL + now.tv_nsec - header->startTime) / 1e9);
+    for (uint32_t r = 0; r < header->nResources; r++) {
+        printf("\t %s: (avail= %d, maxAvail= %d)\n", resources[r].name, readResource(resources[r]),
+               resources[r].maxAvail.load(std::memory_order_relaxed));
+    }
+
+    std::vector<TASK_SAMPLE> samples;
+    long counts[NSTATUS] = {0, 0, 0};
+    for (uint32_t id = 0; id < header->nTasks; id++) {
+        samples.push_back(readTask(tasks[id]));
+        counts[samples.back().status % NSTATUS]++;
+    }
+    std::stable_sort(samples.begin(), samples.end(), [](const TASK_SAMPLE &a, const TASK_SAMPLE &b) {
+        return a.totalWaitTime > b.totalWaitTime;
+    });
+    printf("Tasks: (WAIT= %ld, RUN= %ld, IDLE= %ld, seqlock retries= %ld)\n", counts[WAIT], counts[RUN],
+           counts[IDLE], retries);
+    for (unsigned long i = 0; i < samples.size() && i < MAX_TASK_ROWS; i++) {
+        printf("\t %-12s %-4s (RUN: %d times, WAIT: %d msec, busy: %d msec)\n", samples[i].name,
+               statusNames[samples[i].status % NSTATUS], samples[i].timesExecuted, samples[i].totalWaitTime,
+               samples[i].totalBusyTime);
+    }
+    printf("\n");
+    fflush(stdout);
+    return running;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2 || argc > 4) {
+        printf("Usage: %s name [intervalMsec] [frames]\n", argv[0]);
+        return EINVAL;
+    }
+    std::string name = argv[1][0] == '/' ? argv[1] : std::string("/") + argv[1];
+    long interval = argc > 2 ? atol(argv[2]) : 500;
+    long frames = argc > 3 ? atol(argv[3]) : 0;
+
+    const SIMSTATE_HEADER *header = openSegment(name.c_str());
+    for (long frame = 1; printFrame(name.c_str(), header) && frame != frames; frame++) {
+        usleep(interval * 1000);
+    }
+    return EXIT_SUCCESS;
+}